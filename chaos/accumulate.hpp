@@ -0,0 +1,215 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_ACCUMULATE_HPP__
+#define __CHAOS_ACCUMULATE_HPP__
+
+#include "image.hpp"
+#include "range.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+namespace chaos {
+
+// An AccumulationImage2d counts hits per pixel: writing value adds it to the
+// pixel's count instead of replacing it. Renderers write 1, so drawing into an
+// AccumulationImage2d counts how many times each pixel was drawn. Counts
+// saturate at the largest CountT instead of wrapping. Use ToneMap to turn the
+// counts into an 8-bit image.
+//
+// This replaces AdditiveWriter2d over a uint8_t image: the adds are plain
+// integer adds on a wide buffer, spans and rectangles are added a row at a
+// time, and the mapping to 8 bits is done once, afterwards, in parallel.
+template <std::unsigned_integral CountT = uint32_t>
+class AccumulationImage2d {
+  public:
+    using pixel_type = CountT;
+
+    AccumulationImage2d(int width, int height) : width_(width), height_(height), data_(size_t(width)*height) {}
+
+    void write(int x, int y, pixel_type value) {
+      CountT& count = row(y)[x];
+      count = SaturatingAdd(count, value);
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      CountT* counts = row(y);
+      for (int x = x0; x < x1; x++) {
+        counts[x] = SaturatingAdd(counts[x], value);
+      }
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
+    pixel_type read(int x, int y) const {
+      return row(y)[x];
+    }
+    pixel_type* row(int y) {
+      return data_.data() + size_t(y)*width_;
+    }
+    const pixel_type* row(int y) const {
+      return data_.data() + size_t(y)*width_;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+
+    // Resets every count to zero.
+    void Clear() {
+      std::fill(data_.begin(), data_.end(), 0);
+    }
+
+  private:
+    static CountT SaturatingAdd(CountT a, CountT b) {
+      CountT sum = a + b;
+      return (sum < a) ? std::numeric_limits<CountT>::max() : sum;
+    }
+    int width_;
+    int height_;
+    std::vector<pixel_type> data_;
+};
+
+enum class ToneCurve {
+  // count*scale, clamped to 255. With scale 16 this reproduces
+  // AdditiveWriter2d(image, 16), except that pixels saturate instead of
+  // wrapping after 16 hits.
+  kSaturate,
+  // Maps counts [0, max_count] linearly onto [0, 255].
+  kLinear,
+  // Maps log(1 + count) over [0, log(1 + max_count)] onto [0, 255], which
+  // brings out sparsely hit areas next to dense ones.
+  kLog,
+};
+
+struct ToneMapOptions {
+  ToneCurve curve = ToneCurve::kSaturate;
+  // Used by kSaturate.
+  double scale = 1;
+  // The count mapped to 255 by kLinear and kLog; larger counts saturate. 0
+  // uses the largest count in the image.
+  uint64_t max_count = 0;
+  // Number of threads to resolve with; 0 uses every hardware thread.
+  int threads = 1;
+};
+
+namespace internal {
+
+// kLog maps counts through a lookup table when max_count is below this.
+constexpr uint64_t kToneMapTableSize = 1 << 16;
+
+// Maps one row of counts to 8 bits. The kSaturate and kLinear loops are
+// branch-free so that the compiler vectorizes them.
+template <typename CountT>
+void ToneMapRow(const CountT* counts, int width, ToneCurve curve, float scale, const std::vector<uint8_t>& table, uint8_t* out) {
+  if (curve == ToneCurve::kLog) {
+    uint64_t last = table.size() - 1;
+    for (int x = 0; x < width; x++) {
+      out[x] = table[std::min<uint64_t>(counts[x], last)];
+    }
+    return;
+  }
+  for (int x = 0; x < width; x++) {
+    out[x] = uint8_t(std::min(float(counts[x])*scale + 0.5f, 255.0f));
+  }
+}
+
+template <typename ImageT>
+uint64_t MaxCount(const ImageT& counts, ThreadPool* pool) {
+  std::vector<uint64_t> chunk_max((counts.height() + 63)/64, 0);
+  auto scan = [&](int y0, int y1) {
+    uint64_t m = 0;
+    for (int y = y0; y < y1; y++) {
+      const auto* row = counts.row(y);
+      for (int x = 0; x < counts.width(); x++) {
+        m = std::max<uint64_t>(m, row[x]);
+      }
+    }
+    chunk_max[y0/64] = m;
+  };
+  if (pool == nullptr) {
+    for (int y0 = 0; y0 < counts.height(); y0 += 64) {
+      scan(y0, std::min(counts.height(), y0 + 64));
+    }
+  } else {
+    ParallelForRows(*pool, counts.height(), 64, scan);
+  }
+  return chunk_max.empty() ? 0 : *std::max_element(chunk_max.begin(), chunk_max.end());
+}
+
+}  // namespace internal
+
+// Writes counts, mapped to 8-bit values with options.curve, to dest, which
+// must be at least as large as counts. Rows are resolved in parallel when
+// options.threads != 1.
+template <typename CountT, Image2dWritable DestT>
+void ToneMap(const AccumulationImage2d<CountT>& counts, DestT& dest, const ToneMapOptions& options) {
+  std::optional<ThreadPool> pool;
+  if (options.threads != 1) {
+    pool.emplace(options.threads);
+  }
+  ThreadPool* pool_ptr = pool ? &*pool : nullptr;
+
+  uint64_t max_count = options.max_count;
+  if (max_count == 0 && options.curve != ToneCurve::kSaturate) {
+    max_count = internal::MaxCount(counts, pool_ptr);
+  }
+  float scale = float(options.scale);
+  std::vector<uint8_t> table;
+  if (options.curve == ToneCurve::kLinear) {
+    scale = (max_count == 0) ? 0.0f : 255.0f/max_count;
+  } else if (options.curve == ToneCurve::kLog && max_count < internal::kToneMapTableSize) {
+    // Counts above max_count saturate, so the table only needs to reach it.
+    table.resize(max_count + 1);
+    double denominator = std::log1p(double(max_count));
+    for (size_t count = 0; count < table.size(); count++) {
+      double t = (max_count == 0) ? 0.0 : std::log1p(double(count))/denominator;
+      table[count] = uint8_t(std::min(255.0, 255.0*t + 0.5));
+    }
+  }
+
+  int width = counts.width();
+  auto resolve = [&](int y0, int y1) {
+    std::vector<uint8_t> out(width);
+    for (int y = y0; y < y1; y++) {
+      const CountT* row = counts.row(y);
+      if (options.curve == ToneCurve::kLog && max_count >= internal::kToneMapTableSize) {
+        // Too many distinct counts for the table.
+        double denominator = std::log1p(double(max_count));
+        for (int x = 0; x < width; x++) {
+          double t = std::min(1.0, std::log1p(double(row[x]))/denominator);
+          out[x] = uint8_t(255.0*t + 0.5);
+        }
+      } else {
+        internal::ToneMapRow(row, width, options.curve, scale, table, out.data());
+      }
+      if constexpr (Image2dContiguous<DestT> && std::is_same_v<typename DestT::pixel_type, uint8_t>) {
+        std::memcpy(dest.row(y), out.data(), width);
+      } else {
+        for (int x = 0; x < width; x++) {
+          dest.write(x, y, out[x]);
+        }
+      }
+    }
+  };
+  if (pool_ptr == nullptr) {
+    resolve(0, counts.height());
+  } else {
+    ParallelForRows(*pool_ptr, counts.height(), 64, resolve);
+  }
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_ACCUMULATE_HPP__
@@ -0,0 +1,61 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_BANDED_HPP__
+#define __CHAOS_BANDED_HPP__
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "window_image.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+namespace chaos {
+
+// The Render*Banded functions produce a width x height image without ever
+// holding more than band_height rows of it. draw(image) is called once per
+// band and should draw the complete picture onto image, which has the full
+// output size but only keeps the rows of the current band. Each finished band
+// is appended to the output file and its storage reused for the next, so peak
+// memory is O(width x band_height). Renderers that honour clip_range() skip
+// the parts of the picture that fall outside the band. band_height is
+// clamped to [1, height].
+
+namespace internal {
+inline int ClampBandHeight(int band_height, int height) {
+  return std::clamp(band_height, 1, std::max(height, 1));
+}
+
+template <typename StorageT, typename DrawFn>
+void RenderBanded(PnmStreamWriter& writer, StorageT storage, int band_height, DrawFn& draw) {
+  WindowImage2d<StorageT> image(writer.width(), writer.height(), Range2d(0, 0), std::move(storage));
+  for (int y0 = 0; y0 < writer.height(); y0 += band_height) {
+    int y1 = std::min(writer.height(), y0 + band_height);
+    image.set_window(Range2d(0, y0, writer.width(), y1));
+    draw(image);
+    writer.WriteRows(image.storage(), y1 - y0);
+  }
+}
+}  // namespace internal
+
+// Streams an 8-bit binary (P5) PGM.
+template <typename DrawFn>
+void RenderBandedPgm(const std::string& filename, int width, int height, int band_height, DrawFn draw) {
+  band_height = internal::ClampBandHeight(band_height, height);
+  PnmStreamWriter writer(filename, PnmFormat::kPgm, width, height);
+  internal::RenderBanded(writer, Image2d<uint8_t>(width, band_height), band_height, draw);
+}
+
+// Streams a bit-packed (P4) PBM; nonzero pixels appear white.
+template <typename DrawFn>
+void RenderBandedPbm(const std::string& filename, int width, int height, int band_height, DrawFn draw) {
+  band_height = internal::ClampBandHeight(band_height, height);
+  PnmStreamWriter writer(filename, PnmFormat::kPbm, width, height);
+  internal::RenderBanded(writer, BitImage2d(width, band_height), band_height, draw);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_BANDED_HPP__
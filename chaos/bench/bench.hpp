@@ -0,0 +1,161 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_BENCH_BENCH_HPP__
+#define __CHAOS_BENCH_BENCH_HPP__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chaos {
+namespace bench {
+
+// Integer parameters that identify a benchmark case, e.g. {"size", 729}.
+using Params = std::vector<std::pair<std::string, int64_t>>;
+
+struct Result {
+  std::string name;
+  Params params;
+  // Work done per iteration, usually pixels; 0 if not meaningful.
+  int64_t items = 0;
+  int64_t iterations = 0;
+  double min_ns = 0;
+  double median_ns = 0;
+  double mean_ns = 0;
+};
+
+namespace internal {
+
+inline std::string JsonString(const std::string& s) {
+  std::string out = "\"";
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out += '\\';
+    }
+    out += c;
+  }
+  return out + "\"";
+}
+
+}  // namespace internal
+
+// A Runner times benchmark cases and reports them as JSON.
+//
+// Flags:
+//   --filter=TEXT   only run cases whose name contains TEXT
+//   --min_time=SEC  time each case for at least SEC seconds (default 0.2)
+//   --out=FILE      write the JSON report to FILE instead of stdout
+class Runner {
+  public:
+    Runner(int argc, char** argv) {
+      for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--filter=", 0) == 0) {
+          filter_ = arg.substr(9);
+        } else if (arg.rfind("--min_time=", 0) == 0) {
+          min_time_ = std::stod(arg.substr(11));
+        } else if (arg.rfind("--out=", 0) == 0) {
+          out_ = arg.substr(6);
+        } else {
+          std::cerr << "unknown flag " << arg << std::endl;
+        }
+      }
+    }
+
+    // Times fn(), which performs one iteration of the case. The first call is
+    // a warm-up and is not counted. Cases run for at least min_time and at
+    // least three iterations.
+    template <typename Fn>
+    void Run(const std::string& name, const Params& params, int64_t items, Fn fn) {
+      if (name.find(filter_) == std::string::npos) {
+        return;
+      }
+      using Clock = std::chrono::steady_clock;
+      fn();
+      std::vector<double> times;
+      double total = 0;
+      while (times.size() < 3 || (total < min_time_*1e9 && times.size() < 1000000)) {
+        auto start = Clock::now();
+        fn();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        times.push_back(ns);
+        total += ns;
+      }
+      std::sort(times.begin(), times.end());
+      Result result{name, params, items, int64_t(times.size()), times.front(), times[times.size()/2], total/times.size()};
+      std::cerr << Describe(result) << std::endl;
+      results_.push_back(std::move(result));
+    }
+
+    // Writes the report. Returns the process exit code.
+    int Finish() const {
+      if (out_.empty()) {
+        WriteJson(std::cout);
+        return 0;
+      }
+      std::ofstream outfile(out_);
+      WriteJson(outfile);
+      return outfile ? 0 : 1;
+    }
+
+  private:
+    static std::string Describe(const Result& result) {
+      std::ostringstream out;
+      out << result.name;
+      for (const auto& [key, value] : result.params) {
+        out << " " << key << "=" << value;
+      }
+      out << ": " << result.median_ns/1e6 << " ms";
+      return out.str();
+    }
+
+    void WriteJson(std::ostream& out) const {
+      out << "{\n  \"context\": {\n";
+#ifdef __VERSION__
+      out << "    \"compiler\": " << internal::JsonString(__VERSION__) << ",\n";
+#endif
+#ifdef NDEBUG
+      out << "    \"assertions\": false,\n";
+#else
+      out << "    \"assertions\": true,\n";
+#endif
+      out << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+      out << "    \"min_time_s\": " << min_time_ << "\n  },\n";
+      out << "  \"benchmarks\": [";
+      for (size_t i = 0; i < results_.size(); i++) {
+        const Result& r = results_[i];
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"name\": " << internal::JsonString(r.name) << ", \"params\": {";
+        for (size_t p = 0; p < r.params.size(); p++) {
+          out << (p == 0 ? "" : ", ") << internal::JsonString(r.params[p].first) << ": " << r.params[p].second;
+        }
+        out << "}, \"iterations\": " << r.iterations
+            << ", \"min_ns\": " << int64_t(r.min_ns)
+            << ", \"median_ns\": " << int64_t(r.median_ns)
+            << ", \"mean_ns\": " << int64_t(r.mean_ns)
+            << ", \"items\": " << r.items;
+        if (r.items > 0) {
+          out << ", \"items_per_second\": " << int64_t(r.items/(r.median_ns*1e-9));
+        }
+        out << "}";
+      }
+      out << "\n  ]\n}\n";
+    }
+
+    std::string filter_;
+    double min_time_ = 0.2;
+    std::string out_;
+    std::vector<Result> results_;
+};
+
+}  // namespace bench
+}  // namespace chaos
+
+#endif  // __CHAOS_BENCH_BENCH_HPP__
@@ -0,0 +1,376 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+//
+// Times the renderers and writers over a range of sizes and depths. See
+// bench/bench.hpp for flags. The JSON report goes to stdout (or --out=FILE)
+// and progress to stderr.
+
+#include "accumulate.hpp"
+#include "bench/bench.hpp"
+#include "bit_image.hpp"
+#include "fill.hpp"
+#include "ifs.hpp"
+#include "image.hpp"
+#include "line.hpp"
+#include "pgm.hpp"
+#ifdef CHAOS_HAVE_ZLIB
+#include "png.hpp"
+#endif
+#include "quadtree_image.hpp"
+#include "rle_image.hpp"
+#include "warp.hpp"
+#include "cantor/cantor.hpp"
+#include "cantor/cantor_fixed.hpp"
+#include "cantor/cantor_scanline.hpp"
+#include "cantor/cantor_sweep.hpp"
+
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace chaos;
+using bench::Params;
+using bench::Runner;
+
+namespace {
+
+// Depth used for "render until pixels run out".
+constexpr int kFullDepth = INT_MAX;
+
+int64_t DepthParam(int max_iterations) {
+  return max_iterations == kFullDepth ? -1 : max_iterations;
+}
+
+std::vector<int> ThreadCounts() {
+  std::vector<int> counts = {1};
+  int hardware = std::thread::hardware_concurrency();
+  if (hardware > 1) {
+    counts.push_back(hardware);
+  }
+  return counts;
+}
+
+void BenchCantor1d(Runner& runner) {
+  for (int size : {4096, 65536, 1 << 20}) {
+    for (int depth : {4, kFullDepth}) {
+      Image1d<bool> img(size);
+      runner.Run("DrawCantor1d/Image1d<bool>", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawCantor1d(img, Cantor1dOptions{.max_iterations=depth});
+      });
+      runner.Run("DrawCantor1d/instanced/Image1d<bool>", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawCantor1d(img, Cantor1dOptions{.max_iterations=depth, .instance_subtrees=true});
+      });
+      runner.Run("DrawFixedCantor1d<kMiddleThirdsCantor>/Image1d<bool>", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawFixedCantor1d<kMiddleThirdsCantor>(img, FixedCantor1dOptions{.max_iterations=depth});
+      });
+    }
+  }
+  for (int size : {729, 2187}) {
+    Image2d<bool> canvas(size, size/8);
+    runner.Run("DrawCantor1d/BarImageWriter<Image2d<bool>>", {{"size", size}, {"depth", -1}}, int64_t(size)*(size/8), [&] {
+      BarImageWriter bars(canvas);
+      DrawCantor1d(bars, Cantor1dOptions{});
+    });
+    RleImage2d<bool> rle(size, size/8);
+    runner.Run("DrawCantor1d/BarImageWriter<RleImage2d<bool>>", {{"size", size}, {"depth", -1}}, int64_t(size)*(size/8), [&] {
+      rle.Clear();
+      BarImageWriter bars(rle);
+      DrawCantor1d(bars, Cantor1dOptions{});
+    });
+  }
+}
+
+void BenchCantor1dSweep(Runner& runner) {
+  for (int size : {1024, 4096}) {
+    Image2d<bool> canvas(size, size);
+    for (int threads : ThreadCounts()) {
+      runner.Run("DrawCantor1dSweep", {{"size", size}, {"threads", threads}}, int64_t(size)*size, [&] {
+        DrawCantor1dSweep(canvas, Cantor1dSweepOptions{
+            .top = {.removal_start_ratio = 0.5, .removal_end_ratio = 0.5},
+            .bottom = {.removal_start_ratio = 0, .removal_end_ratio = 1},
+            .threads = threads});
+      });
+    }
+  }
+}
+
+void BenchMultiGapCantor1d(Runner& runner) {
+  MultiGapCantor1dOptions options{
+    .segments = {
+      Range<double>(0.0, 0.1),
+      Range<double>(0.2, 0.3),
+      Range<double>(0.4, 0.5),
+      Range<double>(0.6, 0.7),
+      Range<double>(0.8, 0.9),
+    }
+  };
+  for (int size : {4096, 65536, 1 << 20}) {
+    for (int depth : {3, kFullDepth}) {
+      Image1d<bool> img(size);
+      LineWriter1d writer(img);
+      options.max_iterations = depth;
+      runner.Run("DrawMultiGapCantor1d/LineWriter1d", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawMultiGapCantor1d(writer, options);
+      });
+      runner.Run("DrawFixedMultiGapCantor1d<kEvenRealsCantor>/LineWriter1d", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawFixedMultiGapCantor1d<kEvenRealsCantor>(writer, FixedCantor1dOptions{.max_iterations=depth});
+      });
+      runner.Run("DrawMultiGapCantor1dScanline/Image1d<bool>", {{"size", size}, {"depth", DepthParam(depth)}}, size, [&] {
+        DrawMultiGapCantor1dScanline(img, options);
+      });
+    }
+  }
+  // Overlapping segments, whose subtrees meet at the same intervals over and
+  // over. The recursion visits every path to them.
+  MultiGapCantor1dOptions overlapping{
+    .segments = {
+      Range<double>(0.0, 0.5),
+      Range<double>(0.25, 0.75),
+      Range<double>(0.5, 1.0),
+    }
+  };
+  for (int size : {4096, 65536}) {
+    Image1d<bool> img(size);
+    LineWriter1d writer(img);
+    runner.Run("DrawMultiGapCantor1d/overlapping/LineWriter1d", {{"size", size}, {"depth", DepthParam(kFullDepth)}}, size, [&] {
+      DrawMultiGapCantor1d(writer, overlapping);
+    });
+    runner.Run("DrawMultiGapCantor1dScanline/overlapping/Image1d<bool>", {{"size", size}, {"depth", DepthParam(kFullDepth)}}, size, [&] {
+      DrawMultiGapCantor1dScanline(img, overlapping);
+    });
+  }
+}
+
+void BenchDevilsStaircase1d(Runner& runner) {
+  for (int size : {4096, 65536, 1 << 20}) {
+    Image1d<double> img(size);
+    runner.Run("DrawDevilsStaircase1d/Image1d<double>", {{"size", size}, {"depth", -1}}, size, [&] {
+      DrawDevilsStaircase1d(img, DevilsStaircase1dOptions{.min_y = 0, .max_y = double(size - 1)});
+    });
+  }
+  for (int size : {729, 2187}) {
+    Image2d<bool> canvas(size, size);
+    PlotImageWriter<Image2d<bool>, double> plot(canvas, true);
+    runner.Run("DrawDevilsStaircase1d/PlotImageWriter<Image2d<bool>>", {{"size", size}, {"depth", -1}}, int64_t(size)*size, [&] {
+      DrawDevilsStaircase1d(plot, DevilsStaircase1dOptions{.min_y = 0, .max_y = double(size - 1)});
+    });
+  }
+}
+
+template <typename ImageT>
+void BenchCantor2dOn(Runner& runner, const std::string& image_name) {
+  struct Variant {
+    const char* name;
+    Cantor2dOptions options;
+  };
+  const Variant variants[] = {
+    {"deterministic", Cantor2dOptions{}},
+    {"random", Cantor2dOptions{.seed = 7, .probability = 3.0/5.0}},
+    {"random_counter", Cantor2dOptions{.seed = 7, .probability = 3.0/5.0, .counter_based_random = true}},
+    {"draw_all_iterations", Cantor2dOptions{.draw_all_iterations = true}},
+    {"instanced", Cantor2dOptions{.instance_subtrees = true}},
+    {"draw_all_iterations_instanced", Cantor2dOptions{.draw_all_iterations = true, .instance_subtrees = true}},
+  };
+  for (const Variant& variant : variants) {
+    for (int size : {243, 729, 2187}) {
+      for (int depth : {4, kFullDepth}) {
+        for (int threads : ThreadCounts()) {
+          ImageT img(size, size);
+          Cantor2dOptions options = variant.options;
+          options.max_iterations = depth;
+          options.threads = threads;
+          Params params = {{"size", size}, {"depth", DepthParam(depth)}, {"threads", threads}};
+          runner.Run(std::string("DrawCantor2d/") + variant.name + "/" + image_name, params, int64_t(size)*size, [&] {
+            DrawCantor2d(img, options);
+          });
+          if (!options.probability.has_value() && !options.instance_subtrees) {
+            runner.Run(std::string("DrawCantor2dScanline/") + variant.name + "/" + image_name, params, int64_t(size)*size, [&] {
+              DrawCantor2dScanline(img, options);
+            });
+          }
+        }
+      }
+    }
+  }
+}
+
+void BenchCantor2d(Runner& runner) {
+  BenchCantor2dOn<Image2d<bool>>(runner, "Image2d<bool>");
+  BenchCantor2dOn<Image2d<uint8_t>>(runner, "Image2d<uint8_t>");
+  BenchCantor2dOn<BitImage2d>(runner, "BitImage2d");
+  BenchCantor2dOn<RleImage2d<bool>>(runner, "RleImage2d<bool>");
+  // Quadtree writes must come from one thread.
+  for (int size : {729, 2187, 6561}) {
+    for (int depth : {4, kFullDepth}) {
+      QuadtreeImage2d<bool> tree(size, size);
+      Params params = {{"size", size}, {"depth", DepthParam(depth)}, {"threads", 1}};
+      runner.Run("DrawCantor2d/deterministic/QuadtreeImage2d<bool>", params, int64_t(size)*size, [&] {
+        tree.Clear();
+        DrawCantor2d(tree, Cantor2dOptions{.max_iterations = depth});
+      });
+    }
+  }
+}
+
+// Layered renders: AdditiveWriter2d on 8-bit pixels against counting into an
+// AccumulationImage2d and tone-mapping afterwards.
+void BenchAccumulate(Runner& runner) {
+  Cantor2dOptions options{.max_iterations = 7, .seed = 200, .probability = 4.0/9.0, .draw_all_iterations = true};
+  for (int size : {729, 2187}) {
+    Image2d<uint8_t> canvas(size, size);
+    runner.Run("DrawCantor2d/quilt/AdditiveWriter2d<Image2d<uint8_t>>", {{"size", size}}, int64_t(size)*size, [&] {
+      AdditiveWriter2d writer(canvas, 16);
+      DrawCantor2d(writer, options);
+    });
+    AccumulationImage2d<uint16_t> counts(size, size);
+    runner.Run("DrawCantor2d/quilt/AccumulationImage2d<uint16_t>", {{"size", size}}, int64_t(size)*size, [&] {
+      counts.Clear();
+      DrawCantor2d(counts, options);
+    });
+    for (ToneCurve curve : {ToneCurve::kSaturate, ToneCurve::kLinear, ToneCurve::kLog}) {
+      for (int threads : ThreadCounts()) {
+        runner.Run("ToneMap", {{"size", size}, {"curve", int(curve)}, {"threads", threads}}, int64_t(size)*size, [&] {
+          ToneMap(counts, canvas, ToneMapOptions{.curve = curve, .scale = 16, .threads = threads});
+        });
+      }
+    }
+  }
+}
+
+void BenchIfs(Runner& runner) {
+  constexpr uint64_t kPoints = uint64_t(1) << 24;
+  AccumulationImage2d<uint32_t> counts(1024, 1024);
+  for (int threads : ThreadCounts()) {
+    IfsOptions options{.maps = BarnsleyFernIfs(), .window = {-2.2, 10, 2.7, 0}, .points = kPoints, .threads = threads};
+    runner.Run("DrawIfs/BarnsleyFern", {{"points", int64_t(kPoints)}, {"threads", threads}}, kPoints, [&] {
+      counts.Clear();
+      DrawIfs(counts, options);
+    });
+  }
+}
+
+void BenchPolarArc(Runner& runner) {
+  for (int size : {256, 1024}) {
+    Image2d<bool> canvas(size, size);
+    LineWriterPolarArc writer(canvas, size/8.0, size/2.0);
+    for (int divisor : {64, 8}) {
+      double length = double(writer.width())/divisor;
+      runner.Run("LineWriterPolarArc::DrawLine", {{"size", size}, {"arc_fraction_inverse", divisor}}, 0, [&] {
+        writer.DrawLine(Line1d(0, length), true);
+      });
+    }
+  }
+}
+
+void BenchWarpPolar(Runner& runner) {
+  for (int size : {256, 1024}) {
+    Image2d<bool> canvas(size, size);
+    Image1d<bool> line(int(std::ceil(M_PI*size)));
+    Fill(line, true);
+    for (WarpMapping mapping : {WarpMapping::kPolar, WarpMapping::kLogPolar}) {
+      for (int threads : ThreadCounts()) {
+        PolarWarpOptions options{.inner_r = size/8.0, .outer_r = size/2.0, .mapping = mapping, .threads = threads};
+        runner.Run("WarpPolar", {{"size", size}, {"mapping", int(mapping)}, {"threads", threads}}, int64_t(size)*size, [&] {
+          WarpPolar(line, canvas, options);
+        });
+      }
+    }
+  }
+}
+
+template <typename ImageT>
+void BenchFillOn(Runner& runner, const std::string& image_name) {
+  for (int size : {1024, 4096}) {
+    ImageT img(size, size);
+    runner.Run("Fill/full/" + image_name, {{"size", size}}, int64_t(size)*size, [&] {
+      Fill(img, 1);
+    });
+    // Rows that do not span the image, so each row is a separate span.
+    Range2d inset(1, 1, size - 1, size - 1);
+    runner.Run("Fill/inset/" + image_name, {{"size", size}}, int64_t(size - 2)*(size - 2), [&] {
+      Fill(img, inset, 1);
+    });
+  }
+}
+
+void BenchFill(Runner& runner) {
+  BenchFillOn<Image2d<bool>>(runner, "Image2d<bool>");
+  BenchFillOn<Image2d<uint8_t>>(runner, "Image2d<uint8_t>");
+  BenchFillOn<BitImage2d>(runner, "BitImage2d");
+  for (int size : {4096, 1 << 20}) {
+    Image1d<uint8_t> img(size);
+    runner.Run("Fill/full/Image1d<uint8_t>", {{"size", size}}, size, [&] {
+      Fill(img, 1);
+    });
+  }
+}
+
+template <typename ImageT, typename WriteFn>
+void BenchWriterOn(Runner& runner, const std::string& name, WriteFn write, const Params& extra_params = {}) {
+  std::string filename = (std::filesystem::temp_directory_path() / "chaos_bench.pnm").string();
+  for (int size : {512, 2048}) {
+    ImageT img(size, size);
+    DrawCantor2d(img, Cantor2dOptions{.seed = 7, .probability = 3.0/5.0});
+    Params params = {{"size", size}};
+    params.insert(params.end(), extra_params.begin(), extra_params.end());
+    runner.Run(name, params, int64_t(size)*size, [&] {
+      write(img, filename);
+    });
+  }
+  std::remove(filename.c_str());
+}
+
+void BenchWriters(Runner& runner) {
+  BenchWriterOn<Image2d<uint8_t>>(runner, "WritePgm/Image2d<uint8_t>", [](const auto& img, const std::string& f) {
+    WritePgm(img, f);
+  });
+  BenchWriterOn<Image2d<bool>>(runner, "WriteBlackWhitePgm/Image2d<bool>", [](const auto& img, const std::string& f) {
+    WriteBlackWhitePgm(img, f);
+  });
+  BenchWriterOn<Image2d<uint8_t>>(runner, "WriteBinaryPgm/Image2d<uint8_t>", [](const auto& img, const std::string& f) {
+    WriteBinaryPgm(img, f);
+  });
+  BenchWriterOn<BitImage2d>(runner, "WritePbm/BitImage2d", [](const auto& img, const std::string& f) {
+    WritePbm(img, f);
+  });
+  BenchWriterOn<RleImage2d<bool>>(runner, "WritePbm/RleImage2d<bool>", [](const auto& img, const std::string& f) {
+    WritePbm(img, f);
+  });
+  for (int threads : ThreadCounts()) {
+    BenchWriterOn<QuadtreeImage2d<bool>>(runner, "WriteQuadtreePnm/pbm/QuadtreeImage2d<bool>", [threads](const auto& img, const std::string& f) {
+      WriteQuadtreePnm(img, f, PnmFormat::kPbm, threads);
+    }, {{"threads", threads}});
+  }
+#ifdef CHAOS_HAVE_ZLIB
+  for (int threads : ThreadCounts()) {
+    BenchWriterOn<Image2d<uint8_t>>(runner, "WritePng/gray8/Image2d<uint8_t>", [threads](const auto& img, const std::string& f) {
+      WritePng(img, f, PngOptions{.threads = threads});
+    }, {{"threads", threads}});
+    BenchWriterOn<BitImage2d>(runner, "WritePng/gray1/BitImage2d", [threads](const auto& img, const std::string& f) {
+      WritePng(img, f, PngOptions{.format = PngFormat::kGray1, .threads = threads});
+    }, {{"threads", threads}});
+  }
+#endif
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Runner runner(argc, argv);
+  BenchCantor1d(runner);
+  BenchCantor1dSweep(runner);
+  BenchMultiGapCantor1d(runner);
+  BenchDevilsStaircase1d(runner);
+  BenchCantor2d(runner);
+  BenchAccumulate(runner);
+  BenchIfs(runner);
+  BenchPolarArc(runner);
+  BenchWarpPolar(runner);
+  BenchFill(runner);
+  BenchWriters(runner);
+  return runner.Finish();
+}
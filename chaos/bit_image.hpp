@@ -0,0 +1,109 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_BIT_IMAGE_HPP__
+#define __CHAOS_BIT_IMAGE_HPP__
+
+#include "image.hpp"
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace chaos {
+
+// A BitImage2d is a bilevel image with one bit per pixel. Rows are padded to
+// a whole number of 64-bit words; the padding bits are always zero.
+class BitImage2d {
+  public:
+    using pixel_type = bool;
+    using word_type = uint64_t;
+    static constexpr int kBitsPerWord = 64;
+
+    BitImage2d(int width, int height) : width_(width), height_(height), stride_((width + kBitsPerWord - 1)/kBitsPerWord), data_(size_t(stride_)*height) {}
+    void write(int x, int y, pixel_type value) {
+      word_type& word = data_[size_t(y)*stride_ + x/kBitsPerWord];
+      word_type mask = word_type(1) << (x % kBitsPerWord);
+      if (value) {
+        word |= mask;
+      } else {
+        word &= ~mask;
+      }
+    }
+    pixel_type read(int x, int y) const {
+      return (data_[size_t(y)*stride_ + x/kBitsPerWord] >> (x % kBitsPerWord)) & 1;
+    }
+
+    // Sets pixels [x0, x1) of row y to value using whole-word stores for the
+    // interior of the span.
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      if (x0 >= x1) {
+        return;
+      }
+      word_type* row = row_words(y);
+      int w0 = x0/kBitsPerWord;
+      int w1 = (x1 - 1)/kBitsPerWord;
+      if (w0 == w1) {
+        WriteMasked(row[w0], SpanMask(x0 % kBitsPerWord, (x1 - 1) % kBitsPerWord + 1), value);
+        return;
+      }
+      WriteMasked(row[w0], SpanMask(x0 % kBitsPerWord, kBitsPerWord), value);
+      word_type fill = value ? ~word_type(0) : 0;
+      for (int w = w0 + 1; w < w1; w++) {
+        row[w] = fill;
+      }
+      WriteMasked(row[w1], SpanMask(0, (x1 - 1) % kBitsPerWord + 1), value);
+    }
+
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
+
+    // Returns the number of set pixels.
+    int64_t Count() const {
+      int64_t count = 0;
+      for (word_type word : data_) {
+        count += std::popcount(word);
+      }
+      return count;
+    }
+
+    word_type* row_words(int y) {
+      return data_.data() + size_t(y)*stride_;
+    }
+    const word_type* row_words(int y) const {
+      return data_.data() + size_t(y)*stride_;
+    }
+    // Number of words per row.
+    int stride() const {
+      return stride_;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    // Returns a mask with bits [lo, hi) set, for 0 <= lo < hi <= 64.
+    static word_type SpanMask(int lo, int hi) {
+      word_type upper = (hi == kBitsPerWord) ? ~word_type(0) : ((word_type(1) << hi) - 1);
+      return upper & ~((word_type(1) << lo) - 1);
+    }
+    static void WriteMasked(word_type& word, word_type mask, pixel_type value) {
+      if (value) {
+        word |= mask;
+      } else {
+        word &= ~mask;
+      }
+    }
+    int width_;
+    int height_;
+    int stride_;
+    std::vector<word_type> data_;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_BIT_IMAGE_HPP__
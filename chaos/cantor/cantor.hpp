@@ -3,14 +3,22 @@
 #ifndef __CHAOS_CANTOR_CANTOR_HPP__
 #define __CHAOS_CANTOR_CANTOR_HPP__
 
+#include "coord.hpp"
 #include "fill.hpp"
+#include "instance_cache.hpp"
 #include "rand.hpp"
 #include "line.hpp"
 #include "point.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
 #include "utils.hpp"
 
+#include <climits>
 #include <cstdint>
 #include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
 
 namespace chaos {
 
@@ -21,33 +29,131 @@ struct Cantor1dOptions {
   int max_iterations = INT_MAX;
   double removal_start_ratio = (1.0/3.0);
   double removal_end_ratio = (2.0/3.0);
+  // When set, each distinct interval of at most kCantor1dInstanceExtent
+  // pixels is drawn once and stamped wherever it recurs; see InstanceCache.
+  // This pays off when intervals line up with pixels the same way wherever
+  // they are, as with a middle-thirds set 3^k + 1 pixels wide. Pixels match
+  // a plain render except where rounding at 2^-24 of a pixel decides them,
+  // and stats count only the intervals actually visited. Has no effect on
+  // zoom windows.
+  bool instance_subtrees = false;
 };
 
 namespace internal {
-template <Image1dWritable ImageT> 
-void DrawCantor1d_Range(ImageT& dest, int iteration, double min_x, double max_x, const Cantor1dOptions& options) {
-  if (iteration >= options.max_iterations) {
-    for (int i = int(min_x+0.5); i < int(max_x+0.5); i++) {
-      SafeWrite(dest, i, 1);
+
+// Returns whether a subtree that draws only within the pixels containing
+// coordinates [first, last] can be skipped because dest keeps none of them.
+// Line drawers without a clip range are never culled, since they may map
+// positions outside [0, width) back into view.
+template <typename ImageT, typename CoordT>
+bool Culled1d(const ImageT& dest, CoordT first, CoordT last) {
+  if constexpr (Image1dClipped<ImageT> || Image1dWritable<ImageT>) {
+    Range<int> clip = ClipRange1d(dest);
+    return clip.x1 <= clip.x0 || last < clip.x0 || first >= clip.x1;
+  } else {
+    return false;
+  }
+}
+
+// Returns whether every child interval lies within its parent, which culling
+// relies on.
+inline bool Cantor1dNested(const Cantor1dOptions& options) {
+  return options.removal_start_ratio >= 0 && options.removal_start_ratio <= 1 &&
+      options.removal_end_ratio >= 0 && options.removal_end_ratio <= 1;
+}
+
+// Intervals at most this many pixels wide are instanced.
+constexpr double kCantor1dInstanceExtent = 256;
+
+template <Image1dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor1d_Instance(ImageT& dest, int iteration, CoordT min_x, CoordT max_x, const Cantor1dOptions& options, StatsT& stats, InstanceCache& instances);
+
+template <Image1dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor1d_Range(ImageT& dest, int iteration, CoordT min_x, CoordT max_x, const Cantor1dOptions& options, StatsT& stats, InstanceCache* instances) {
+  // Leaves draw within one pixel of [min_x, max_x].
+  if (Culled1d(dest, min_x - 1, max_x + 1) && Cantor1dNested(options)) {
+    return;
+  }
+  if constexpr (std::is_same_v<CoordT, double>) {
+    // Leaves can draw one pixel left of min_x, which the recording would
+    // lose at the left edge of the image.
+    if (instances != nullptr && max_x - min_x <= kCantor1dInstanceExtent && min_x >= 1) {
+      DrawCantor1d_Instance(dest, iteration, min_x, max_x, options, stats, *instances);
+      return;
     }
+  }
+  stats.Visit(iteration);
+  if (iteration >= options.max_iterations) {
+    Fill(dest, PixelIndex(min_x+0.5), PixelIndex(max_x+0.5), 1);
     return;
   }
   if (max_x - min_x <= 1) {
-    int p = int((min_x+ max_x)/2);
-    SafeWrite(dest, p-1, 1);
-    SafeWrite(dest, p, 1);
-    SafeWrite(dest, p+1, 1);
+    stats.Cutoff(iteration);
+    int p = PixelIndex((min_x+ max_x)/2);
+    SafeFill(dest, p-1, p+2, 1, stats);
     return;
   } else {
-    DrawCantor1d_Range(dest, iteration+1, min_x, min_x + (max_x - min_x)*options.removal_start_ratio, options);
-    DrawCantor1d_Range(dest, iteration+1, min_x + (max_x-min_x)*options.removal_end_ratio, max_x, options);
+    DrawCantor1d_Range(dest, iteration+1, min_x, min_x + (max_x - min_x)*options.removal_start_ratio, options, stats, instances);
+    DrawCantor1d_Range(dest, iteration+1, min_x + (max_x-min_x)*options.removal_end_ratio, max_x, options, stats, instances);
+  }
+}
+
+// Stamps the interval [min_x, max_x], recording it first if it is the first
+// of its kind. Intervals are alike when they start at the same depth and the
+// same position within a pixel, and are the same width.
+template <Image1dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor1d_Instance(ImageT& dest, int iteration, CoordT min_x, CoordT max_x, const Cantor1dOptions& options, StatsT& stats, InstanceCache& instances) {
+  int x = PixelIndex(min_x);
+  InstanceKey key = {iteration, InstanceKeyCoord(min_x - x), InstanceKeyCoord(max_x - min_x)};
+  const InstanceRecording* recording = instances.Find(key);
+  if (recording == nullptr) {
+    if (!instances.WorthRecording()) {
+      DrawCantor1d_Range(dest, iteration, min_x, max_x, options, stats, nullptr);
+      return;
+    }
+    InstanceRecording runs;
+    RecordingImage1d recorder(x, runs);
+    DrawCantor1d_Range(recorder, iteration, min_x, max_x, options, stats, nullptr);
+    NormalizeRecording(runs);
+    recording = &instances.Insert(key, std::move(runs));
+  }
+  StampInstance(dest, *recording, x, ClipRange1d(dest), 1);
+}
+
+// Draws a whole Cantor set over [min_x, max_x], instancing if options ask.
+template <Image1dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor1d_Root(ImageT& dest, CoordT min_x, CoordT max_x, const Cantor1dOptions& options, StatsT& stats) {
+  if (options.instance_subtrees) {
+    InstanceCache instances;
+    DrawCantor1d_Range(dest, 0, min_x, max_x, options, stats, &instances);
+    return;
   }
+  DrawCantor1d_Range(dest, 0, min_x, max_x, options, stats, nullptr);
 }
 }  // namespace internal
 
+template <Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawCantor1d(ImageT& dest, const Cantor1dOptions& options, StatsT& stats) {
+  internal::DrawCantor1d_Root(dest, 0.0, double(dest.width()-1), options, stats);
+}
+
 template <Image1dWritable ImageT> 
 void DrawCantor1d(ImageT& dest, const Cantor1dOptions& options) {
-  internal::DrawCantor1d_Range(dest, 0, 0, dest.width()-1, options);
+  NullRenderStats stats;
+  DrawCantor1d(dest, options, stats);
+}
+
+// Draws the part of a Cantor set laid out over window.width pixels that falls
+// within dest, which shows window pixels [x0, x0 + dest.width()).
+template <Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawCantor1d(ImageT& dest, const Cantor1dOptions& options, const ZoomWindow1d& window, StatsT& stats) {
+  internal::DrawCantor1d_Root(dest, -window.x0, window.width - 1 - window.x0, options, stats);
+}
+
+template <Image1dWritable ImageT>
+void DrawCantor1d(ImageT& dest, const Cantor1dOptions& options, const ZoomWindow1d& window) {
+  NullRenderStats stats;
+  DrawCantor1d(dest, options, window, stats);
 }
 
 // -----------------------------------------------------------------------------
@@ -59,25 +165,61 @@ struct MultiGapCantor1dOptions {
 };
 
 namespace internal {
-template <Line1dDrawable DrawT> 
-void DrawMultiGapCantor1d_Range(DrawT& dest, int iteration, Line1d line, const MultiGapCantor1dOptions& options) {
+
+// Returns whether every segment lies within [0, 1] in increasing order, so
+// that each line's subtree stays within the line.
+inline bool MultiGapCantor1dNested(const MultiGapCantor1dOptions& options) {
+  return std::all_of(options.segments.begin(), options.segments.end(), [](const Range<double>& segment) {
+    return segment.x0 >= 0 && segment.x0 <= segment.x1 && segment.x1 <= 1;
+  });
+}
+
+template <Line1dDrawable DrawT, typename CoordT, RenderStatsCollector StatsT>
+void DrawMultiGapCantor1d_Range(DrawT& dest, int iteration, BasicLine1d<CoordT> line, const MultiGapCantor1dOptions& options, StatsT& stats) {
+  if (Culled1d(dest, line.x0, line.x1) && MultiGapCantor1dNested(options)) {
+    return;
+  }
+  stats.Visit(iteration);
   if ((iteration >= options.max_iterations) || (line.width() < 1.0)) {
-    dest.DrawLine(line, 1);
+    if (iteration < options.max_iterations) {
+      stats.Cutoff(iteration);
+    }
+    dest.DrawLine(Line1d(double(line.x0), double(line.x1)), 1);
     return;
   }
   for (auto& segment : options.segments) {
     DrawMultiGapCantor1d_Range(
         dest,
         iteration+1,
-        Line1d(Lerp(line.x0, line.x1, segment.x0), Lerp(line.x0, line.x1, segment.x1)),
-        options);
+        BasicLine1d<CoordT>(Lerp(line.x0, line.x1, segment.x0), Lerp(line.x0, line.x1, segment.x1)),
+        options,
+        stats);
   }
 }
 }  // namespace internal
 
+template <Line1dDrawable DrawT, RenderStatsCollector StatsT>
+void DrawMultiGapCantor1d(DrawT& dest, const MultiGapCantor1dOptions& options, StatsT& stats) {
+  internal::DrawMultiGapCantor1d_Range(dest, 0, Line1d(dest.width()-1), options, stats);
+}
+
 template <Line1dDrawable DrawT> 
 void DrawMultiGapCantor1d(DrawT& dest, const MultiGapCantor1dOptions& options) {
-  internal::DrawMultiGapCantor1d_Range(dest, 0, Line1d(dest.width()-1), options);
+  NullRenderStats stats;
+  DrawMultiGapCantor1d(dest, options, stats);
+}
+
+// As DrawCantor1d with a ZoomWindow1d.
+template <Line1dDrawable DrawT, RenderStatsCollector StatsT>
+void DrawMultiGapCantor1d(DrawT& dest, const MultiGapCantor1dOptions& options, const ZoomWindow1d& window, StatsT& stats) {
+  BasicLine1d<DoubleDouble> line(-window.x0, window.width - 1 - window.x0);
+  internal::DrawMultiGapCantor1d_Range(dest, 0, line, options, stats);
+}
+
+template <Line1dDrawable DrawT>
+void DrawMultiGapCantor1d(DrawT& dest, const MultiGapCantor1dOptions& options, const ZoomWindow1d& window) {
+  NullRenderStats stats;
+  DrawMultiGapCantor1d(dest, options, window, stats);
 }
 
 // -----------------------------------------------------------------------------
@@ -87,20 +229,30 @@ struct DevilsStaircase1dOptions {
   int max_iterations = INT_MAX;
   double min_y = 0;
   double max_y = 255;
+  // Number of threads to fill the area under the curve with when drawing
+  // onto a PlotImageWriter; 0 uses every hardware thread.
+  int threads = 1;
 };
 
 namespace internal {
-template <Image1dWritable ImageT> 
-void DevilsStaircase1d_Range(ImageT& dest, int iteration, double min_x, double
+template <Image1dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DevilsStaircase1d_Range(ImageT& dest, int iteration, CoordT min_x, CoordT
                              max_x, double min_y, double max_y, const
-                             DevilsStaircase1dOptions& options) {
+                             DevilsStaircase1dOptions& options, StatsT& stats) {
+  if (Culled1d(dest, min_x, max_x)) {
+    return;
+  }
+  stats.Visit(iteration);
   if (max_x - min_x <= 1) {
+    stats.Cutoff(iteration);
     int y = int((min_y+ max_y)/2);
-    Fill(dest, int(min_x), int(max_x), y);
+    Fill(dest, PixelIndex(min_x), PixelIndex(max_x), y);
     return;
   } else if (iteration >= options.max_iterations) {
-    for (int x = min_x; x < max_x; x++) {
-      double t = (x - min_x) / (max_x - min_x);
+    // Zoomed windows can put min_x and max_x far outside dest.
+    int x_end = std::min(dest.width(), PixelIndex(max_x) + 1);
+    for (int x = std::max(0, PixelIndex(min_x)); x < max_x && x < x_end; x++) {
+      double t = double((x - min_x) / (max_x - min_x));
       double y = min_y + t*(max_y-min_y);
       dest.write(x, y);
     }
@@ -108,32 +260,202 @@ void DevilsStaircase1d_Range(ImageT& dest, int iteration, double min_x, double
   }
   if (max_x - min_x <= 1) {
     int y = int((min_y+ max_y)/2);
-    Fill(dest, int(min_x), int(max_x), y);
+    Fill(dest, PixelIndex(min_x), PixelIndex(max_x), y);
     return;
   } else {
     double avg_y = (min_y + max_y)/2.0;
-    double start_x = min_x + (max_x - min_x)/3.0;
-    double end_x = min_x + 2*(max_x - min_x)/3.0;
+    CoordT start_x = min_x + (max_x - min_x)/3.0;
+    CoordT end_x = min_x + 2*(max_x - min_x)/3.0;
     DevilsStaircase1d_Range(
         dest,
         iteration+1,
         min_x, start_x,
         min_y, avg_y,
-        options);
+        options,
+        stats);
     DevilsStaircase1d_Range(
         dest,
         iteration+1,
         end_x, max_x,
         avg_y, max_y,
-        options);
-    Fill(dest, int(start_x), int(end_x), int(avg_y));
+        options,
+        stats);
+    Fill(dest, PixelIndex(start_x), PixelIndex(end_x), int(avg_y));
   }
 }
 }  // namespace internal
 
+template <Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawDevilsStaircase1d(ImageT& dest, const DevilsStaircase1dOptions& options, StatsT& stats) {
+  internal::DevilsStaircase1d_Range(dest, 0, 0.0, double(dest.width()-1), options.min_y, options.max_y, options, stats);
+}
+
 template <Image1dWritable ImageT> 
 void DrawDevilsStaircase1d(ImageT& dest, const DevilsStaircase1dOptions& options) {
-  internal::DevilsStaircase1d_Range(dest, 0, 0, dest.width()-1, options.min_y, options.max_y, options);
+  NullRenderStats stats;
+  DrawDevilsStaircase1d(dest, options, stats);
+}
+
+// As DrawCantor1d with a ZoomWindow1d. The staircase still rises from
+// options.min_y to options.max_y across the whole window.width.
+template <Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawDevilsStaircase1d(ImageT& dest, const DevilsStaircase1dOptions& options, const ZoomWindow1d& window, StatsT& stats) {
+  internal::DevilsStaircase1d_Range(dest, 0, -window.x0, window.width - 1 - window.x0, options.min_y, options.max_y, options, stats);
+}
+
+template <Image1dWritable ImageT>
+void DrawDevilsStaircase1d(ImageT& dest, const DevilsStaircase1dOptions& options, const ZoomWindow1d& window) {
+  NullRenderStats stats;
+  DrawDevilsStaircase1d(dest, options, window, stats);
+}
+
+namespace internal {
+
+// Collects the height of the tallest column written to each x of a
+// PlotImageWriter, in place of drawing the columns.
+template <Image2dWritable UnderlyingImageT, typename PixelT>
+class PlotHeights {
+  public:
+    using pixel_type = PixelT;
+    explicit PlotHeights(const PlotImageWriter<UnderlyingImageT, PixelT>& plot)
+        : heights_(plot.width(), 0), clip_(plot.clip_range()) {}
+    void write(int x, pixel_type value) {
+      heights_[x] = std::max(heights_[x], int(value));
+    }
+    Range<int> clip_range() const {
+      return clip_;
+    }
+    int width() const {
+      return heights_.size();
+    }
+    const std::vector<int>& heights() const {
+      return heights_;
+    }
+  private:
+    std::vector<int> heights_;
+    Range<int> clip_;
+};
+
+// Sets, in dest, the pixels below heights[x] in each column x within clip,
+// a row at a time. Runs are found with one sweep across the columns: a run
+// of row y starts where the heights rise past y and ends where they fall to
+// it, so the sweep costs the width plus the total rise and fall.
+template <Image2dWritable ImageT>
+void FillUnderHeights(ImageT& dest, const std::vector<int>& heights, Range2d clip, typename ImageT::pixel_type value, int threads) {
+  int rows = std::max(0, clip.y1);
+  struct Run {
+    int y;
+    int x0;
+    int x1;
+  };
+  std::vector<Run> runs;
+  std::vector<int> run_start(rows);
+  int prev = 0;
+  for (int x = clip.x0; x <= clip.x1; x++) {
+    int height = x < clip.x1 ? std::clamp(heights[x], 0, rows) : 0;
+    for (int y = prev; y < height; y++) {
+      run_start[y] = x;
+    }
+    for (int y = height; y < prev; y++) {
+      runs.push_back(Run{y, run_start[y], x});
+    }
+    prev = height;
+  }
+  // Group the runs by row.
+  std::vector<int> row_begin(rows + 1, 0);
+  for (const Run& run : runs) {
+    row_begin[run.y + 1]++;
+  }
+  for (int y = 0; y < rows; y++) {
+    row_begin[y + 1] += row_begin[y];
+  }
+  std::vector<Range<int>> row_runs(runs.size(), Range<int>(0, 0));
+  std::vector<int> next(row_begin.begin(), row_begin.end() - 1);
+  for (const Run& run : runs) {
+    row_runs[next[run.y]++] = Range<int>(run.x0, run.x1);
+  }
+  auto fill_rows = [&](int y0, int y1) {
+    for (int y = std::max(y0, clip.y0); y < y1; y++) {
+      for (int i = row_begin[y]; i < row_begin[y + 1]; i++) {
+        WriteSpan(dest, row_runs[i].x0, row_runs[i].x1, y, value);
+      }
+    }
+  };
+  if (threads == 1) {
+    fill_rows(0, rows);
+    return;
+  }
+  ThreadPool pool(threads);
+  ParallelForRows(pool, rows, 64, fill_rows);
+}
+
+}  // namespace internal
+
+// Draws the same pixels as the generic DrawDevilsStaircase1d, but rather than
+// drawing a column per write, finds the tallest column at each x and then
+// fills the area under the curve a row at a time with span writes.
+template <Image2dWritable UnderlyingImageT, typename PixelT, RenderStatsCollector StatsT>
+void DrawDevilsStaircase1d(PlotImageWriter<UnderlyingImageT, PixelT>& dest, const DevilsStaircase1dOptions& options, StatsT& stats) {
+  internal::PlotHeights heights(dest);
+  internal::DevilsStaircase1d_Range(heights, 0, 0.0, double(dest.width()-1), options.min_y, options.max_y, options, stats);
+  internal::FillUnderHeights(dest.underlying(), heights.heights(), ClipRange(dest.underlying()), dest.value(), options.threads);
+}
+
+template <Image2dWritable UnderlyingImageT, typename PixelT>
+void DrawDevilsStaircase1d(PlotImageWriter<UnderlyingImageT, PixelT>& dest, const DevilsStaircase1dOptions& options) {
+  NullRenderStats stats;
+  DrawDevilsStaircase1d(dest, options, stats);
+}
+
+// Evaluates the Cantor function, which the Devil's staircase plots, at each
+// of x[0, n), writing the results to y. Points outside [0, 1] are clamped to
+// it. Each point is evaluated directly from its base-3 digits: digits of 0
+// and 2 contribute binary digits of 0 and 1, and the first 1 ends the
+// expansion with a final binary 1. The digits are taken in integer
+// arithmetic from x scaled once to a 33-digit base-3 fixed-point number, so
+// they carry no rounding error beyond that one scaling, and results are
+// exact to about 2^-33. Points are taken in blocks, a digit at a time across
+// the block with arithmetic in place of branches, so the compiler vectorizes
+// the digit loop; with threads != 1 the blocks are split across threads.
+inline void EvaluateCantorFunction(const double* x, double* y, int n, int threads = 1) {
+  constexpr int kBlock = 256;
+  constexpr int kDigits = 33;
+  // 3^kDigits, which is below 2^53, so x*kOne is within a rounding of exact.
+  constexpr int64_t kOne = 5559060566555523;
+  auto evaluate = [&](int i0, int i1) {
+    // The base-3 fraction still to be expanded, in units of 1/kOne.
+    int64_t t[kBlock];
+    // The binary digits produced so far.
+    int64_t bits[kBlock];
+    // 1 until a digit of 1 ends the expansion, then 0.
+    int64_t live[kBlock];
+    for (int b0 = i0; b0 < i1; b0 += kBlock) {
+      int count = std::min(kBlock, i1 - b0);
+      for (int j = 0; j < count; j++) {
+        t[j] = std::min(int64_t(std::clamp(x[b0 + j], 0.0, 1.0)*double(kOne)), kOne - 1);
+        bits[j] = 0;
+        live[j] = 1;
+      }
+      for (int digit = 0; digit < kDigits; digit++) {
+        for (int j = 0; j < count; j++) {
+          int64_t u = t[j]*3;
+          int64_t d = int64_t(u >= kOne) + int64_t(u >= 2*kOne);
+          t[j] = u - d*kOne;
+          bits[j] = 2*bits[j] + (live[j] & int64_t(d != 0));
+          live[j] &= int64_t(d != 1);
+        }
+      }
+      for (int j = 0; j < count; j++) {
+        y[b0 + j] = x[b0 + j] >= 1 ? 1.0 : double(bits[j])*0x1.0p-33;
+      }
+    }
+  };
+  if (threads == 1) {
+    evaluate(0, n);
+    return;
+  }
+  ThreadPool pool(threads);
+  ParallelForRows(pool, n, 16*kBlock, evaluate);
 }
 
 // -----------------------------------------------------------------------------
@@ -144,54 +466,279 @@ struct Cantor2dOptions {
   unsigned int seed = 0;
   std::optional<double> probability = std::nullopt;
   bool draw_all_iterations = false;
+  // Number of threads to render with; 0 uses every hardware thread. With more
+  // than one thread, dest must accept concurrent writes to different rows
+  // that are at least 26 rows apart; images less than 81 pixels wide or tall
+  // are rendered serially. The output is identical to a serial render.
+  // Random dust drawn with the sequential generator is always rendered
+  // serially, since each sub-square depends on every draw before it; set
+  // counter_based_random to render it in parallel.
+  int threads = 1;
+  // When set, whether a sub-square is drawn is a pure function of
+  // (seed, depth, path), computed with CounterRandom, rather than the next
+  // draw from a sequential generator. Decisions then do not depend on
+  // traversal order, so any sub-square can be rendered on its own and
+  // random dust can be rendered in parallel. A given seed produces a different
+  // pattern than with the sequential generator.
+  bool counter_based_random = false;
+  // When set, dust without a probability draws each distinct square of at
+  // most kCantor2dInstanceExtent pixels once and stamps it wherever it
+  // recurs, as with Cantor1dOptions::instance_subtrees. Squares repeat when
+  // the image is 3^k pixels on a side.
+  bool instance_subtrees = false;
 };
 
 namespace internal {
-template <Image2dWritable ImageT> 
-void DrawCantor2d_Range(ImageT& dest, Random<double>& random, int iteration, Point2 min, Point2 max, const Cantor2dOptions& options) {
+
+// Names a square of the subdivision for counter-based random choices. digits
+// holds one base-9 digit per level since the last multiple of
+// kCantor2dPathDigits levels, and key stands for every level above those,
+// starting from the seed at the root. Paths are exact down to depth 20 and
+// collide with probability about 2^-64 below it, so deep zooms do not reuse
+// the choices of unrelated squares.
+struct Cantor2dPath {
+  uint64_t key = 0;
+  uint64_t digits = 0;
+};
+
+// Returns the path of the root square.
+inline Cantor2dPath Cantor2dRootPath(const Cantor2dOptions& options) {
+  return Cantor2dPath{options.seed, 0};
+}
+
+// Levels of base-9 digits that fit in Cantor2dPath::digits.
+constexpr int kCantor2dPathDigits = 20;
+
+// Returns the path of sub-square (i, j) of the square at path and depth
+// iteration. Once digits is full, it is folded into a new key drawn from the
+// old one, at an index no choice uses.
+inline Cantor2dPath Cantor2dSubPath(const Cantor2dPath& path, int iteration, int i, int j) {
+  Cantor2dPath sub_path = path;
+  if (iteration > 0 && iteration % kCantor2dPathDigits == 0) {
+    uint32_t key[2];
+    CounterRandom(path.key).FillBits(path.digits, uint64_t(1) << 62, key, 2);
+    sub_path = Cantor2dPath{key[0] | uint64_t(key[1]) << 32, 0};
+  }
+  sub_path.digits = sub_path.digits*9 + j*3 + i;
+  return sub_path;
+}
+
+// Returns whether sub-square (i, j), at the given path and depth, is drawn.
+inline bool Cantor2dChoose(Random<double>& random, int i, int j, const Cantor2dPath& sub_path, int sub_iteration, const Cantor2dOptions& options) {
+  if (!options.probability.has_value()) {
+    return (i != 1 && j != 1);
+  }
+  if (options.counter_based_random) {
+    return CounterRandom(sub_path.key).ZeroToOne(sub_path.digits, sub_iteration) < *options.probability;
+  }
+  return random.ZeroToOne() < *options.probability;
+}
+
+// Returns whether sub-squares are chosen by the sequential generator, whose
+// draws must happen in serial order.
+inline bool Cantor2dSequentialRandom(const Cantor2dOptions& options) {
+  return options.probability.has_value() && !options.counter_based_random;
+}
+
+// Returns whether the square [min, max) can be skipped because none of the
+// pixels it would draw are kept by dest. Squares are never skipped while the
+// sequential generator is in use, since skipping would change its state.
+template <Image2dWritable ImageT, typename CoordT>
+bool Cantor2dCulled(const ImageT& dest, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options) {
+  if (Cantor2dSequentialRandom(options)) {
+    return false;
+  }
+  // A square draws within the pixels containing [min, max] on each axis.
+  Range2d clip = ClipRange(dest);
+  return clip.empty() | (max.x < clip.x0) | (max.y < clip.y0) | (min.x >= clip.x1) | (min.y >= clip.y1);
+}
+
+// Squares at most this many pixels on a side are instanced.
+constexpr double kCantor2dInstanceExtent = 27;
+
+template <Image2dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor2d_Instance(ImageT& dest, Random<double>& random, int iteration, const Cantor2dPath& path, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options, StatsT& stats, InstanceCache& instances);
+
+// instances, if not null, is used for squares of at most
+// kCantor2dInstanceExtent pixels.
+template <Image2dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor2d_Range(ImageT& dest, Random<double>& random, int iteration, const Cantor2dPath& path, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options, StatsT& stats, InstanceCache* instances) {
+  if (Cantor2dCulled(dest, min, max, options)) {
+    return;
+  }
+  if constexpr (std::is_same_v<CoordT, double>) {
+    if (instances != nullptr && max.x - min.x <= kCantor2dInstanceExtent && max.y - min.y <= kCantor2dInstanceExtent) {
+      DrawCantor2d_Instance(dest, random, iteration, path, min, max, options, stats, *instances);
+      return;
+    }
+  }
+  stats.Visit(iteration);
   if (iteration >= options.max_iterations) {
-    Fill(dest, Range2d(int(min.x), int(min.y), int(max.x), int(max.y)), 1);
+    Fill(dest, Range2d(PixelIndex(min.x), PixelIndex(min.y), PixelIndex(max.x), PixelIndex(max.y)), 1);
     return;
   }
   if ((max.x - min.x <= 1) && (max.y - min.y) <= 1) {
-    int x = int((min.x + max.x)/2);
-    int y = int((min.y + max.y)/2);
-    SafeWrite(dest, x, y, 1);
+    stats.Cutoff(iteration);
+    int x = PixelIndex((min.x + max.x)/2);
+    int y = PixelIndex((min.y + max.y)/2);
+    SafeWrite(dest, x, y, 1, stats);
     return;
   } else {
     for (int j = 0; j < 3; j++) {
       for (int i = 0; i < 3; i++) {
-        bool draw = (i != 1 && j != 1);
-        if (options.probability.has_value()) {
-          draw = random.ZeroToOne() < *options.probability;
-        }
-        if (draw) {
-          double x0 = min.x + i*(max.x - min.x)/3;
-          double y0 = min.y + j*(max.y - min.y)/3;
-          double x1 = min.x + (i+1)*(max.x - min.x)/3;
-          double y1 = min.y + (j+1)*(max.y - min.y)/3;
+        Cantor2dPath sub_path = Cantor2dSubPath(path, iteration, i, j);
+        if (Cantor2dChoose(random, i, j, sub_path, iteration+1, options)) {
+          BasicPoint2<CoordT> sub_min(min.x + i*(max.x - min.x)/3, min.y + j*(max.y - min.y)/3);
+          BasicPoint2<CoordT> sub_max(min.x + (i+1)*(max.x - min.x)/3, min.y + (j+1)*(max.y - min.y)/3);
           if (options.draw_all_iterations) {
-            Fill(dest, Range2d(int(x0), int(y0), int(x1), int(y1)), 1);
+            Fill(dest, Range2d(PixelIndex(sub_min.x), PixelIndex(sub_min.y), PixelIndex(sub_max.x), PixelIndex(sub_max.y)), 1);
           }
           DrawCantor2d_Range(
             dest,
             random,
             iteration+1,
-            Point2(x0, y0),
-            Point2(x1, y1),
-            options);
+            sub_path,
+            sub_min,
+            sub_max,
+            options,
+            stats,
+            instances);
         }
       }
     }
   }
 }
 
+// As DrawCantor1d_Instance. Instanced squares are deterministic, so path
+// and random are only passed along.
+template <Image2dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor2d_Instance(ImageT& dest, Random<double>& random, int iteration, const Cantor2dPath& path, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options, StatsT& stats, InstanceCache& instances) {
+  int x = PixelIndex(min.x);
+  int y = PixelIndex(min.y);
+  InstanceKey key = {iteration, InstanceKeyCoord(min.x - x), InstanceKeyCoord(min.y - y),
+                     InstanceKeyCoord(max.x - min.x), InstanceKeyCoord(max.y - min.y)};
+  const InstanceRecording* recording = instances.Find(key);
+  if (recording == nullptr) {
+    if (!instances.WorthRecording()) {
+      DrawCantor2d_Range(dest, random, iteration, path, min, max, options, stats, nullptr);
+      return;
+    }
+    InstanceRecording runs;
+    RecordingImage2d recorder(x, y, runs);
+    DrawCantor2d_Range(recorder, random, iteration, path, min, max, options, stats, nullptr);
+    NormalizeRecording(runs);
+    recording = &instances.Insert(key, std::move(runs));
+  }
+  StampInstance(dest, *recording, x, y, ClipRange(dest), 1);
+}
+
+// Sub-squares narrower or shorter than this many pixels are rendered serially
+// by DrawCantor2d_Parallel. Rows 0 and 2 of a square at least this tall are
+// kept apart by a row 1 at least a third as tall, so their pixel rows never
+// meet. Requiring the width too keeps those rows over 2000 pixels apart in
+// memory, so they do not share words even in a bit-packed image whose rows
+// are not word-aligned, like Image2d<bool>.
+constexpr double kCantor2dParallelCutoff = 81;
+
+// Renders the same pixels as DrawCantor2d_Range, handing large sub-squares to
+// pool. Rows 0 and 2 of the 3x3 subdivision are rendered concurrently, then
+// row 1, so tasks that run at the same time never write to neighbouring rows.
+// Sub-squares must not be chosen by the sequential generator.
+template <Image2dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor2d_Parallel(ThreadPool& pool, ImageT& dest, Random<double>& random, int iteration, const Cantor2dPath& path, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options, StatsT& stats, InstanceCache* instances) {
+  if (Cantor2dCulled(dest, min, max, options)) {
+    return;
+  }
+  if (iteration >= options.max_iterations ||
+      max.x - min.x < kCantor2dParallelCutoff || max.y - min.y < kCantor2dParallelCutoff) {
+    DrawCantor2d_Range(dest, random, iteration, path, min, max, options, stats, instances);
+    return;
+  }
+  stats.Visit(iteration);
+  struct SubSquare {
+    bool draw;
+    Cantor2dPath path;
+    BasicPoint2<CoordT> min;
+    BasicPoint2<CoordT> max;
+  };
+  std::vector<SubSquare> squares;
+  squares.reserve(9);
+  for (int j = 0; j < 3; j++) {
+    for (int i = 0; i < 3; i++) {
+      Cantor2dPath sub_path = Cantor2dSubPath(path, iteration, i, j);
+      bool draw = Cantor2dChoose(random, i, j, sub_path, iteration+1, options);
+      BasicPoint2<CoordT> sub_min(min.x + i*(max.x - min.x)/3, min.y + j*(max.y - min.y)/3);
+      BasicPoint2<CoordT> sub_max(min.x + (i+1)*(max.x - min.x)/3, min.y + (j+1)*(max.y - min.y)/3);
+      squares.push_back(SubSquare{draw, sub_path, sub_min, sub_max});
+    }
+  }
+  auto draw_row = [&](int j) {
+    for (int i = 0; i < 3; i++) {
+      SubSquare& square = squares[j*3 + i];
+      if (!square.draw) {
+        continue;
+      }
+      if (options.draw_all_iterations) {
+        Fill(dest, Range2d(PixelIndex(square.min.x), PixelIndex(square.min.y), PixelIndex(square.max.x), PixelIndex(square.max.y)), 1);
+      }
+      DrawCantor2d_Parallel(pool, dest, random, iteration+1, square.path, square.min, square.max, options, stats, instances);
+    }
+  };
+  TaskGroup outer_rows;
+  pool.Run(outer_rows, [&] { draw_row(0); });
+  pool.Run(outer_rows, [&] { draw_row(2); });
+  pool.Wait(outer_rows);
+  draw_row(1);
+}
+
+// Renders the square [min, max) at the given depth and path, serially or on
+// options.threads threads.
+template <Image2dWritable ImageT, typename CoordT, RenderStatsCollector StatsT>
+void DrawCantor2d_Root(ImageT& dest, int iteration, const Cantor2dPath& path, BasicPoint2<CoordT> min, BasicPoint2<CoordT> max, const Cantor2dOptions& options, StatsT& stats) {
+  Random<double> random(options.seed);
+  std::optional<InstanceCache> instances;
+  if (options.instance_subtrees && !options.probability.has_value()) {
+    instances.emplace();
+  }
+  InstanceCache* instances_ptr = instances ? &*instances : nullptr;
+  if (options.threads != 1 && !Cantor2dSequentialRandom(options)) {
+    ThreadPool pool(options.threads);
+    DrawCantor2d_Parallel(pool, dest, random, iteration, path, min, max, options, stats, instances_ptr);
+    return;
+  }
+  DrawCantor2d_Range(dest, random, iteration, path, min, max, options, stats, instances_ptr);
+}
+
 }  // namespace internal
 
+// With a RenderStats, stats is shared by every thread of the render.
+template <Image2dWritable ImageT, RenderStatsCollector StatsT>
+void DrawCantor2d(ImageT& dest, const Cantor2dOptions& options, StatsT& stats) {
+  internal::DrawCantor2d_Root(dest, 0, internal::Cantor2dRootPath(options), Point2(0, 0), Point2(dest.width(), dest.height()), options, stats);
+}
+
 template <Image2dWritable ImageT> 
 void DrawCantor2d(ImageT& dest, const Cantor2dOptions& options) {
-  Random<double> random(options.seed);
-  internal::DrawCantor2d_Range(dest, random, 0, Point2(0, 0), Point2(dest.width(), dest.height()), options);
+  NullRenderStats stats;
+  DrawCantor2d(dest, options, stats);
+}
+
+// Draws the part of a Cantor dust laid out over window.width x window.height
+// pixels that falls within dest, which shows window pixels from (x0, y0). Only
+// squares that reach dest are visited, unless sub-squares are chosen by the
+// sequential generator, which has to visit every square and so is only
+// practical for shallow zooms.
+template <Image2dWritable ImageT, RenderStatsCollector StatsT>
+void DrawCantor2d(ImageT& dest, const Cantor2dOptions& options, const ZoomWindow2d& window, StatsT& stats) {
+  BasicPoint2<DoubleDouble> min(-window.x0, -window.y0);
+  BasicPoint2<DoubleDouble> max(window.width - window.x0, window.height - window.y0);
+  internal::DrawCantor2d_Root(dest, 0, internal::Cantor2dRootPath(options), min, max, options, stats);
+}
+
+template <Image2dWritable ImageT>
+void DrawCantor2d(ImageT& dest, const Cantor2dOptions& options, const ZoomWindow2d& window) {
+  NullRenderStats stats;
+  DrawCantor2d(dest, options, window, stats);
 }
 
 } // namespace chaos
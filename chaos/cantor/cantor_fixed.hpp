@@ -0,0 +1,195 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_CANTOR_CANTOR_FIXED_HPP__
+#define __CHAOS_CANTOR_CANTOR_FIXED_HPP__
+
+#include "cantor/cantor.hpp"
+#include "fill.hpp"
+#include "image.hpp"
+#include "line.hpp"
+#include "range.hpp"
+#include "stats.hpp"
+#include "utils.hpp"
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <utility>
+
+namespace chaos {
+
+// Fixed renderers draw the same pixels as DrawCantor1d and
+// DrawMultiGapCantor1d for a pattern known at compile time. The segment loop
+// is unrolled, the ratios fold into the arithmetic, and whether the pattern
+// nests is decided once rather than at every step. When max_iterations is
+// deeper than the subdivision can go before intervals shrink below a pixel,
+// which is computed from the pattern up front, the depth test is dropped too.
+
+// A CantorPattern lists the segments that each interval is replaced with, as
+// fractions of the interval. It is used as a template argument.
+template <size_t N>
+struct CantorPattern {
+  std::array<Range<double>, N> segments;
+
+  // Returns whether every segment lies within [0, 1] in increasing order.
+  constexpr bool Nested() const {
+    for (const Range<double>& segment : segments) {
+      if (!(segment.x0 >= 0 && segment.x0 <= segment.x1 && segment.x1 <= 1)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  // Returns the width of the widest segment.
+  constexpr double MaxRatio() const {
+    double ratio = 0;
+    for (const Range<double>& segment : segments) {
+      ratio = std::max(ratio, segment.width());
+    }
+    return ratio;
+  }
+};
+
+// The classic middle-thirds set.
+inline constexpr CantorPattern<2> kMiddleThirdsCantor{{
+  Range<double>(0.0, 1.0/3.0), Range<double>(2.0/3.0, 1.0),
+}};
+// Removes the second quarter of each interval.
+inline constexpr CantorPattern<2> kSecondQuarterCantor{{
+  Range<double>(0.0, 1.0/4.0), Range<double>(2.0/4.0, 1.0),
+}};
+// Keeps the five even tenths of each interval: the "even reals" set drawn by
+// even_reals.cc.
+inline constexpr CantorPattern<5> kEvenRealsCantor{{
+  Range<double>(0.0, 0.1), Range<double>(0.2, 0.3), Range<double>(0.4, 0.5),
+  Range<double>(0.6, 0.7), Range<double>(0.8, 0.9),
+}};
+
+struct FixedCantor1dOptions {
+  int max_iterations = INT_MAX;
+};
+
+namespace internal {
+
+// Returns the depth by which every interval of a pattern with the given
+// widest ratio, starting at width, is at most half a pixel wide, leaving room
+// for rounding. Returns INT_MAX if intervals need not shrink.
+inline int FixedCantorCutoffDepth(double width, double max_ratio) {
+  if (!(max_ratio < 1)) {
+    return INT_MAX;
+  }
+  int depth = 0;
+  for (; width > 0.5; width *= max_ratio) {
+    depth++;
+  }
+  return depth;
+}
+
+template <CantorPattern Pattern, bool kDepthLimited, Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawFixedCantor1d_Range(ImageT& dest, int iteration, double min_x, double max_x, int max_iterations, StatsT& stats) {
+  constexpr double kRemovalStartRatio = Pattern.segments[0].x1;
+  constexpr double kRemovalEndRatio = Pattern.segments[1].x0;
+  if constexpr (Pattern.Nested()) {
+    if (Culled1d(dest, min_x - 1, max_x + 1)) {
+      return;
+    }
+  }
+  stats.Visit(iteration);
+  if constexpr (kDepthLimited) {
+    if (iteration >= max_iterations) {
+      Fill(dest, int(min_x+0.5), int(max_x+0.5), 1);
+      return;
+    }
+  }
+  if (max_x - min_x <= 1) {
+    stats.Cutoff(iteration);
+    int p = int((min_x+ max_x)/2);
+    SafeFill(dest, p-1, p+2, 1, stats);
+    return;
+  }
+  DrawFixedCantor1d_Range<Pattern, kDepthLimited>(dest, iteration+1, min_x, min_x + (max_x - min_x)*kRemovalStartRatio, max_iterations, stats);
+  DrawFixedCantor1d_Range<Pattern, kDepthLimited>(dest, iteration+1, min_x + (max_x-min_x)*kRemovalEndRatio, max_x, max_iterations, stats);
+}
+
+template <CantorPattern Pattern, bool kDepthLimited, Line1dDrawable DrawT, RenderStatsCollector StatsT, size_t... I>
+void DrawFixedMultiGapCantor1d_Children(DrawT& dest, int iteration, Line1d line, int max_iterations, StatsT& stats, std::index_sequence<I...>);
+
+template <CantorPattern Pattern, bool kDepthLimited, Line1dDrawable DrawT, RenderStatsCollector StatsT>
+void DrawFixedMultiGapCantor1d_Range(DrawT& dest, int iteration, Line1d line, int max_iterations, StatsT& stats) {
+  if constexpr (Pattern.Nested()) {
+    if (Culled1d(dest, line.x0, line.x1)) {
+      return;
+    }
+  }
+  stats.Visit(iteration);
+  if constexpr (kDepthLimited) {
+    if (iteration >= max_iterations) {
+      dest.DrawLine(line, 1);
+      return;
+    }
+  }
+  if (line.width() < 1.0) {
+    stats.Cutoff(iteration);
+    dest.DrawLine(line, 1);
+    return;
+  }
+  DrawFixedMultiGapCantor1d_Children<Pattern, kDepthLimited>(
+      dest, iteration+1, line, max_iterations, stats, std::make_index_sequence<Pattern.segments.size()>());
+}
+
+// Draws the children of line, one per segment of Pattern.
+template <CantorPattern Pattern, bool kDepthLimited, Line1dDrawable DrawT, RenderStatsCollector StatsT, size_t... I>
+void DrawFixedMultiGapCantor1d_Children(DrawT& dest, int iteration, Line1d line, int max_iterations, StatsT& stats, std::index_sequence<I...>) {
+  (DrawFixedMultiGapCantor1d_Range<Pattern, kDepthLimited>(
+      dest,
+      iteration,
+      Line1d(Lerp(line.x0, line.x1, Pattern.segments[I].x0), Lerp(line.x0, line.x1, Pattern.segments[I].x1)),
+      max_iterations,
+      stats), ...);
+}
+
+}  // namespace internal
+
+// Draws the same pixels as DrawCantor1d with removal_start_ratio and
+// removal_end_ratio taken from Pattern, which must have two segments, the
+// first starting at 0 and the second ending at 1.
+template <CantorPattern Pattern, Image1dWritable ImageT, RenderStatsCollector StatsT>
+void DrawFixedCantor1d(ImageT& dest, const FixedCantor1dOptions& options, StatsT& stats) {
+  static_assert(Pattern.segments.size() == 2 && Pattern.segments[0].x0 == 0 && Pattern.segments[1].x1 == 1,
+                "DrawFixedCantor1d patterns remove one gap from each interval");
+  double max_x = dest.width() - 1;
+  constexpr double kMaxRatio = Pattern.MaxRatio();
+  if (options.max_iterations > internal::FixedCantorCutoffDepth(max_x, kMaxRatio)) {
+    internal::DrawFixedCantor1d_Range<Pattern, false>(dest, 0, 0.0, max_x, options.max_iterations, stats);
+  } else {
+    internal::DrawFixedCantor1d_Range<Pattern, true>(dest, 0, 0.0, max_x, options.max_iterations, stats);
+  }
+}
+
+template <CantorPattern Pattern, Image1dWritable ImageT>
+void DrawFixedCantor1d(ImageT& dest, const FixedCantor1dOptions& options) {
+  NullRenderStats stats;
+  DrawFixedCantor1d<Pattern>(dest, options, stats);
+}
+
+// Draws the same pixels as DrawMultiGapCantor1d with Pattern's segments.
+template <CantorPattern Pattern, Line1dDrawable DrawT, RenderStatsCollector StatsT>
+void DrawFixedMultiGapCantor1d(DrawT& dest, const FixedCantor1dOptions& options, StatsT& stats) {
+  Line1d line(dest.width()-1);
+  constexpr double kMaxRatio = Pattern.MaxRatio();
+  if (options.max_iterations > internal::FixedCantorCutoffDepth(line.width(), kMaxRatio)) {
+    internal::DrawFixedMultiGapCantor1d_Range<Pattern, false>(dest, 0, line, options.max_iterations, stats);
+  } else {
+    internal::DrawFixedMultiGapCantor1d_Range<Pattern, true>(dest, 0, line, options.max_iterations, stats);
+  }
+}
+
+template <CantorPattern Pattern, Line1dDrawable DrawT>
+void DrawFixedMultiGapCantor1d(DrawT& dest, const FixedCantor1dOptions& options) {
+  NullRenderStats stats;
+  DrawFixedMultiGapCantor1d<Pattern>(dest, options, stats);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_CANTOR_CANTOR_FIXED_HPP__
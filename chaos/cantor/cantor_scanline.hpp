@@ -0,0 +1,383 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_CANTOR_CANTOR_SCANLINE_HPP__
+#define __CHAOS_CANTOR_CANTOR_SCANLINE_HPP__
+
+#include "cantor/cantor.hpp"
+#include "fill.hpp"
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chaos {
+
+// Scanline renderers produce the same pixels as DrawCantor1d and DrawCantor2d
+// without recursing over the 2-D tree. They first compute which pixels each
+// level of the subdivision covers along a single axis, then build every
+// output row by OR-ing those 1-D masks together. Rows are independent and are
+// rendered in parallel. Every pixel is written once, so the results match the
+// recursive renderers for writers where repeated writes of the same value are
+// idempotent (everything but the additive writers).
+
+namespace internal {
+
+// A span of set pixels [first, second). Unlike PixelRun, it has no value.
+using PixelSpan = std::pair<int, int>;
+
+inline void AppendRuns(const uint8_t* mask, int width, std::vector<PixelSpan>& runs) {
+  int x = 0;
+  while (x < width) {
+    while (x < width && !mask[x]) {
+      x++;
+    }
+    int start = x;
+    while (x < width && mask[x]) {
+      x++;
+    }
+    if (start < x) {
+      runs.emplace_back(start, x);
+    }
+  }
+}
+
+inline void SetMask(std::vector<uint8_t>& mask, int x0, int x1) {
+  x0 = std::max(0, x0);
+  x1 = std::min(int(mask.size()), x1);
+  if (x0 < x1) {
+    std::fill(mask.begin() + x0, mask.begin() + x1, 1);
+  }
+}
+
+// Computes the pixels that DrawCantor1d would set on an image of the given
+// width, walking the subdivision one level at a time with the same
+// arithmetic as DrawCantor1d_Range.
+inline std::vector<uint8_t> Cantor1dMask(int width, const Cantor1dOptions& options) {
+  struct Interval {
+    double min_x;
+    double max_x;
+  };
+  std::vector<uint8_t> mask(std::max(0, width), 0);
+  std::vector<Interval> level = {Interval{0, double(width - 1)}};
+  std::vector<Interval> next;
+  for (int iteration = 0; !level.empty(); iteration++) {
+    next.clear();
+    for (const Interval& interval : level) {
+      double min_x = interval.min_x;
+      double max_x = interval.max_x;
+      if (iteration >= options.max_iterations) {
+        SetMask(mask, int(min_x+0.5), int(max_x+0.5));
+      } else if (max_x - min_x <= 1) {
+        int p = int((min_x+ max_x)/2);
+        SetMask(mask, p-1, p+2);
+      } else {
+        next.push_back(Interval{min_x, min_x + (max_x - min_x)*options.removal_start_ratio});
+        next.push_back(Interval{min_x + (max_x-min_x)*options.removal_end_ratio, max_x});
+      }
+    }
+    std::swap(level, next);
+  }
+  return mask;
+}
+
+// Merges the sorted runs of level into drawn, which is sorted and has no
+// runs that overlap or touch, keeping it that way.
+inline void MergeRuns(std::vector<PixelSpan>& drawn, const std::vector<PixelSpan>& level) {
+  if (level.empty()) {
+    return;
+  }
+  if (drawn.empty() || level.front().first >= drawn.back().first) {
+    // Appends in place, as when every leaf is at the same depth.
+    for (const PixelSpan& run : level) {
+      if (!drawn.empty() && run.first <= drawn.back().second) {
+        drawn.back().second = std::max(drawn.back().second, run.second);
+      } else {
+        drawn.push_back(run);
+      }
+    }
+    return;
+  }
+  std::vector<PixelSpan> merged;
+  merged.reserve(drawn.size() + level.size());
+  auto append = [&](PixelSpan run) {
+    if (!merged.empty() && run.first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, run.second);
+    } else {
+      merged.push_back(run);
+    }
+  };
+  auto a = drawn.begin();
+  auto b = level.begin();
+  while (a != drawn.end() || b != level.end()) {
+    if (b == level.end() || (a != drawn.end() && a->first <= b->first)) {
+      append(*a++);
+    } else {
+      append(*b++);
+    }
+  }
+  drawn = std::move(merged);
+}
+
+// Returns whether drawn, as kept by MergeRuns, covers all of [x0, x1).
+inline bool RunsCover(const std::vector<PixelSpan>& drawn, int x0, int x1) {
+  auto it = std::upper_bound(drawn.begin(), drawn.end(), x0, [](int x, const PixelSpan& run) {
+    return x < run.second;
+  });
+  return x0 >= x1 || (it != drawn.end() && it->first <= x0 && it->second >= x1);
+}
+
+// Computes the runs of pixels within clip that DrawMultiGapCantor1d would set
+// through a LineWriter1d on an image of the given width. The tree is walked
+// one level at a time from an explicit work list, with the arithmetic of
+// DrawMultiGapCantor1d_Range. Each level is kept sorted, identical intervals
+// (which overlapping segments produce) are descended only once, and, when
+// subtrees stay within their intervals, an interval whose pixels are already
+// all set is not descended at all. Leaves are snapped to the pixels
+// DrawLine would fill and merged as they are found.
+inline std::vector<PixelSpan> MultiGapCantor1dRuns(int width, Range<int> clip, const MultiGapCantor1dOptions& options) {
+  bool nested = MultiGapCantor1dNested(options);
+  std::vector<PixelSpan> drawn;
+  std::vector<PixelSpan> leaves;
+  std::vector<Line1d> level;
+  std::vector<Line1d> next;
+  // Sets aside line, at the given depth, to be descended or drawn.
+  auto visit = [&](const Line1d& line, int iteration) {
+    if (nested && (line.x1 < clip.x0 || line.x0 >= clip.x1)) {
+      return;
+    }
+    if ((iteration < options.max_iterations) && (line.width() >= 1.0)) {
+      next.push_back(line);
+      return;
+    }
+    // The pixels LineWriter1d::DrawLine fills for line, within clip.
+    int x0 = std::max(clip.x0, int(line.x0+0.5));
+    int x1 = std::min(clip.x1, int(line.x1+0.5));
+    if (x0 >= x1) {
+      return;
+    }
+    if (!leaves.empty() && x0 <= leaves.back().second && x0 >= leaves.back().first) {
+      leaves.back().second = std::max(leaves.back().second, x1);
+    } else {
+      leaves.emplace_back(x0, x1);
+    }
+  };
+  auto by_position = [](const Line1d& a, const Line1d& b) {
+    return a.x0 < b.x0 || (a.x0 == b.x0 && a.x1 < b.x1);
+  };
+  auto same = [](const Line1d& a, const Line1d& b) {
+    return a.x0 == b.x0 && a.x1 == b.x1;
+  };
+  if (clip.x0 < clip.x1) {
+    visit(Line1d(width - 1), 0);
+  }
+  for (int iteration = 0; !next.empty() || !leaves.empty(); iteration++) {
+    if (!std::is_sorted(leaves.begin(), leaves.end())) {
+      std::sort(leaves.begin(), leaves.end());
+    }
+    MergeRuns(drawn, leaves);
+    leaves.clear();
+    if (nested && RunsCover(drawn, clip.x0, clip.x1)) {
+      break;
+    }
+    std::swap(level, next);
+    next.clear();
+    if (!std::is_sorted(level.begin(), level.end(), by_position)) {
+      std::sort(level.begin(), level.end(), by_position);
+    }
+    level.erase(std::unique(level.begin(), level.end(), same), level.end());
+    next.reserve(level.size()*options.segments.size());
+    for (const Line1d& line : level) {
+      // A nested subtree sets no pixels outside those of its line.
+      if (nested && RunsCover(drawn, std::max(clip.x0, int(line.x0+0.5)), std::min(clip.x1, int(line.x1+0.5)))) {
+        continue;
+      }
+      for (const Range<double>& segment : options.segments) {
+        visit(Line1d(Lerp(line.x0, line.x1, segment.x0), Lerp(line.x0, line.x1, segment.x1)), iteration+1);
+      }
+    }
+  }
+  return drawn;
+}
+
+// The pixels covered along one axis by the squares at one depth of the 2-D
+// subdivision. A square's parent counts as small when it was at most one
+// pixel across on this axis; a pair of squares exists in 2-D unless both
+// parents were small, since the parent pair would have been a leaf.
+struct Cantor2dAxisLevel {
+  // mid[p]: midpoint pixels of small squares whose parent has small == p.
+  std::vector<uint8_t> mid[2];
+  // range[p]: [int(min), int(max)) of all squares whose parent has small == p.
+  std::vector<uint8_t> range[2];
+  bool all_small = true;
+};
+
+class Cantor2dAxis {
+  public:
+    explicit Cantor2dAxis(int extent) : extent_(extent), nodes_{Node{0, double(extent), false}} {}
+
+    Cantor2dAxisLevel Level() const {
+      Cantor2dAxisLevel level;
+      for (int p = 0; p < 2; p++) {
+        level.mid[p].assign(extent_, 0);
+        level.range[p].assign(extent_, 0);
+      }
+      for (const Node& node : nodes_) {
+        bool small = node.max - node.min <= 1;
+        level.all_small = level.all_small && small;
+        int p = node.parent_small;
+        if (small) {
+          int m = int((node.min + node.max)/2);
+          SetMask(level.mid[p], m, m+1);
+        }
+        SetMask(level.range[p], int(node.min), int(node.max));
+      }
+      return level;
+    }
+
+    // Replaces the squares with their drawn children (indices 0 and 2).
+    void Descend() {
+      std::vector<Node> children;
+      children.reserve(2*nodes_.size());
+      for (const Node& node : nodes_) {
+        bool small = node.max - node.min <= 1;
+        for (int i = 0; i < 3; i += 2) {
+          children.push_back(Node{
+            node.min + i*(node.max - node.min)/3,
+            node.min + (i+1)*(node.max - node.min)/3,
+            small});
+        }
+      }
+      nodes_ = std::move(children);
+    }
+
+  private:
+    struct Node {
+      double min;
+      double max;
+      bool parent_small;
+    };
+    int extent_;
+    std::vector<Node> nodes_;
+};
+
+}  // namespace internal
+
+// Draws the same pixels as DrawCantor1d.
+template <Image1dWritable ImageT>
+void DrawCantor1dScanline(ImageT& dest, const Cantor1dOptions& options) {
+  std::vector<uint8_t> mask = internal::Cantor1dMask(dest.width(), options);
+  std::vector<internal::PixelSpan> runs;
+  internal::AppendRuns(mask.data(), mask.size(), runs);
+  for (auto [x0, x1] : runs) {
+    Fill(dest, x0, x1, 1);
+  }
+}
+
+// Draws the same pixels as DrawMultiGapCantor1d on a LineWriter1d of dest,
+// setting each pixel once. Unlike the recursion, its work is bounded by the
+// distinct intervals of at least a pixel, not by the paths to them, which
+// pays off when segments overlap and subtrees keep meeting at the same
+// intervals. Other patterns cost about what the recursion does, or more when
+// their levels need sorting.
+template <Image1dWritable ImageT>
+void DrawMultiGapCantor1dScanline(ImageT& dest, const MultiGapCantor1dOptions& options) {
+  for (auto [x0, x1] : internal::MultiGapCantor1dRuns(dest.width(), ClipRange1d(dest), options)) {
+    Fill(dest, x0, x1, 1);
+  }
+}
+
+// Draws the same pixels as DrawCantor2d. Random dust (options.probability)
+// has no row structure and is handed to DrawCantor2d.
+template <Image2dWritable ImageT>
+void DrawCantor2dScanline(ImageT& dest, const Cantor2dOptions& options) {
+  if (options.probability.has_value()) {
+    DrawCantor2d(dest, options);
+    return;
+  }
+  int width = dest.width();
+  int height = dest.height();
+  std::vector<internal::Cantor2dAxisLevel> x_levels;
+  std::vector<internal::Cantor2dAxisLevel> y_levels;
+  internal::Cantor2dAxis x_axis(width);
+  internal::Cantor2dAxis y_axis(height);
+  for (int depth = 0;; depth++) {
+    x_levels.push_back(x_axis.Level());
+    y_levels.push_back(y_axis.Level());
+    if (depth >= options.max_iterations || (x_levels.back().all_small && y_levels.back().all_small)) {
+      break;
+    }
+    x_axis.Descend();
+    y_axis.Descend();
+  }
+  int num_levels = x_levels.size();
+
+  // Row y is the union, over depths, of the x masks selected by y's
+  // membership in the matching y masks. Rows with the same memberships are
+  // identical, so each distinct combination is only built once per chunk.
+  Range2d clip = ClipRange(dest);
+  auto draw_rows = [&](int y0, int y1) {
+    std::unordered_map<std::string, std::vector<internal::PixelSpan>> cache;
+    std::vector<uint8_t> row(width);
+    std::string key(num_levels, 0);
+    for (int y = std::max(y0, clip.y0); y < std::min(y1, clip.y1); y++) {
+      for (int d = 0; d < num_levels; d++) {
+        const internal::Cantor2dAxisLevel& level = y_levels[d];
+        key[d] = char(level.mid[0][y] | level.mid[1][y] << 1 | level.range[0][y] << 2 | level.range[1][y] << 3);
+      }
+      auto [it, inserted] = cache.try_emplace(key);
+      if (inserted) {
+        std::fill(row.begin(), row.end(), 0);
+        auto merge = [&](const std::vector<uint8_t>& mask) {
+          for (int x = 0; x < width; x++) {
+            row[x] |= mask[x];
+          }
+        };
+        for (int d = 0; d < num_levels; d++) {
+          const internal::Cantor2dAxisLevel& yl = y_levels[d];
+          const internal::Cantor2dAxisLevel& xl = x_levels[d];
+          if (d < options.max_iterations) {
+            // Leaves: both squares small and not both parents small.
+            if (yl.mid[0][y] || yl.mid[1][y]) {
+              merge(xl.mid[0]);
+            }
+            if (yl.mid[0][y]) {
+              merge(xl.mid[1]);
+            }
+          }
+          if (d == options.max_iterations || (options.draw_all_iterations && d > 0)) {
+            // Filled squares: every pair that exists at this depth.
+            if (yl.range[0][y] || yl.range[1][y]) {
+              merge(xl.range[0]);
+            }
+            if (yl.range[0][y]) {
+              merge(xl.range[1]);
+            }
+          }
+        }
+        internal::AppendRuns(row.data(), width, it->second);
+      }
+      for (auto [x0, x1] : it->second) {
+        x0 = std::max(x0, clip.x0);
+        x1 = std::min(x1, clip.x1);
+        if (x0 < x1) {
+          internal::WriteSpan(dest, x0, x1, y, 1);
+        }
+      }
+    }
+  };
+  if (options.threads == 1) {
+    draw_rows(0, height);
+    return;
+  }
+  ThreadPool pool(options.threads);
+  ParallelForRows(pool, height, 64, draw_rows);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_CANTOR_CANTOR_SCANLINE_HPP__
@@ -0,0 +1,150 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_CANTOR_CANTOR_SWEEP_HPP__
+#define __CHAOS_CANTOR_CANTOR_SWEEP_HPP__
+
+#include "cantor/cantor.hpp"
+#include "image.hpp"
+#include "range.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace chaos {
+
+// A sweep draws a different Cantor set on every row of an image, so that the
+// effect of a parameter can be seen down the image. Each row gets the same
+// pixels as DrawCantor1d on a RowWriter1d of that row, but rows are rendered
+// in parallel, and a row's leaves are merged into runs before anything is
+// written, so each row costs a few span writes rather than one per leaf.
+
+struct Cantor1dSweepOptions {
+  // The options of the top and bottom rows. Rows between them interpolate
+  // every field linearly, with max_iterations rounded to the nearest integer.
+  Cantor1dOptions top;
+  Cantor1dOptions bottom;
+  // Number of threads to render with; 0 uses every hardware thread.
+  int threads = 1;
+};
+
+namespace internal {
+
+// Scratch space for rendering rows, reused from row to row by each thread.
+struct Cantor1dRowBuffer {
+  struct Node {
+    double min_x;
+    double max_x;
+    int iteration;
+  };
+  std::vector<Node> stack;
+  // Runs of set pixels [x0, x1).
+  std::vector<std::pair<int, int>> runs;
+};
+
+// Fills buffer.runs with the pixels that DrawCantor1d would set within clip
+// on an image of the given width, using the same arithmetic as
+// DrawCantor1d_Range.
+inline void Cantor1dRowRuns(int width, Range<int> clip, const Cantor1dOptions& options, Cantor1dRowBuffer& buffer) {
+  buffer.runs.clear();
+  if (clip.x1 <= clip.x0) {
+    return;
+  }
+  bool nested = Cantor1dNested(options);
+  // Leaves are visited left to right, so in a nested set each one starts no
+  // earlier than the one before, and usually extends the last run. A leaf
+  // that starts before the last run gets a run of its own; writing a pixel
+  // twice does no harm.
+  auto add = [&](int x0, int x1) {
+    x0 = std::max(x0, clip.x0);
+    x1 = std::min(x1, clip.x1);
+    if (x0 >= x1) {
+      return;
+    }
+    if (!buffer.runs.empty() && x0 >= buffer.runs.back().first && x0 <= buffer.runs.back().second) {
+      buffer.runs.back().second = std::max(buffer.runs.back().second, x1);
+    } else {
+      buffer.runs.emplace_back(x0, x1);
+    }
+  };
+  auto& stack = buffer.stack;
+  stack.clear();
+  stack.push_back({0.0, double(width - 1), 0});
+  while (!stack.empty()) {
+    auto [min_x, max_x, iteration] = stack.back();
+    stack.pop_back();
+    // Leaves draw within one pixel of [min_x, max_x].
+    if (nested && (max_x + 1 < clip.x0 || min_x - 1 >= clip.x1)) {
+      continue;
+    }
+    if (iteration >= options.max_iterations) {
+      add(int(min_x+0.5), int(max_x+0.5));
+    } else if (max_x - min_x <= 1) {
+      int p = int((min_x+ max_x)/2);
+      add(p-1, p+2);
+    } else {
+      // The right child is pushed first so that the left one is drawn first.
+      stack.push_back({min_x + (max_x-min_x)*options.removal_end_ratio, max_x, iteration+1});
+      stack.push_back({min_x, min_x + (max_x - min_x)*options.removal_start_ratio, iteration+1});
+    }
+  }
+}
+
+inline Cantor1dOptions Cantor1dSweepRow(const Cantor1dSweepOptions& options, int y, int height) {
+  double t = height > 1 ? double(y)/(height - 1) : 0.0;
+  auto lerp = [t](double a, double b) {
+    return a + (b - a)*t;
+  };
+  return Cantor1dOptions{
+    .max_iterations = int(std::lround(lerp(options.top.max_iterations, options.bottom.max_iterations))),
+    .removal_start_ratio = lerp(options.top.removal_start_ratio, options.bottom.removal_start_ratio),
+    .removal_end_ratio = lerp(options.top.removal_end_ratio, options.bottom.removal_end_ratio),
+  };
+}
+
+}  // namespace internal
+
+// Draws, on each row y of dest, the Cantor set with options row_options(y).
+template <Image2dWritable ImageT, typename RowOptionsFn>
+  requires std::regular_invocable<const RowOptionsFn&, int> &&
+      std::convertible_to<std::invoke_result_t<const RowOptionsFn&, int>, Cantor1dOptions>
+void DrawCantor1dSweep(ImageT& dest, const RowOptionsFn& row_options, int threads = 1) {
+  Range2d clip = ClipRange(dest);
+  if (clip.empty()) {
+    return;
+  }
+  int width = dest.width();
+  auto draw_rows = [&](int row0, int row1) {
+    internal::Cantor1dRowBuffer buffer;
+    for (int y = clip.y0 + row0; y < clip.y0 + row1; y++) {
+      internal::Cantor1dRowRuns(width, Range<int>(clip.x0, clip.x1), row_options(y), buffer);
+      for (auto [x0, x1] : buffer.runs) {
+        internal::WriteSpan(dest, x0, x1, y, 1);
+      }
+    }
+  };
+  if (threads == 1) {
+    draw_rows(0, clip.height());
+    return;
+  }
+  ThreadPool pool(threads);
+  ParallelForRows(pool, clip.height(), 16, draw_rows);
+}
+
+// Draws a sweep from options.top on the first row of dest to options.bottom
+// on the last.
+template <Image2dWritable ImageT>
+void DrawCantor1dSweep(ImageT& dest, const Cantor1dSweepOptions& options) {
+  int height = dest.height();
+  DrawCantor1dSweep(dest, [&](int y) {
+    return internal::Cantor1dSweepRow(options, y, height);
+  }, options.threads);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_CANTOR_CANTOR_SWEEP_HPP__
@@ -0,0 +1,101 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_CANTOR_CANTOR_ZOOM_HPP__
+#define __CHAOS_CANTOR_CANTOR_ZOOM_HPP__
+
+#include "cantor/cantor.hpp"
+#include "fill.hpp"
+#include "image.hpp"
+#include "point.hpp"
+#include "stats.hpp"
+
+#include <cstdint>
+#include <limits>
+
+namespace chaos {
+
+// A Cantor2dAddress names one square of the Cantor dust subdivision exactly:
+// column x, row y of the 3^depth x 3^depth grid of squares at that depth.
+// Each level contributes one base-3 digit to x and y, most significant first,
+// so with IndexT = uint64_t addresses reach depth 40, and with
+// unsigned __int128, depth 80. depth must not exceed kMaxDepth.
+template <typename IndexT = uint64_t>
+struct Cantor2dAddress {
+  // The deepest depth whose grid fits in IndexT.
+  static constexpr int kMaxDepth = [] {
+    int depth = 0;
+    for (IndexT size = 1; size <= std::numeric_limits<IndexT>::max()/3; size *= 3) {
+      depth++;
+    }
+    return depth;
+  }();
+
+  int depth = 0;
+  IndexT x = 0;
+  IndexT y = 0;
+
+  // Returns the address of sub-square (i, j), each in [0, 3), of this square.
+  Cantor2dAddress Child(int i, int j) const {
+    return Cantor2dAddress{depth + 1, x*3 + IndexT(i), y*3 + IndexT(j)};
+  }
+};
+
+// Draws the square at address onto the whole of dest, as it would appear in
+// a DrawCantor2d render 3^address.depth times the size of dest. The address
+// is walked with integer arithmetic, so the result is exact at any depth
+// IndexT can hold, and costs no more than a render of dest itself.
+//
+// With options.probability, sub-squares are chosen as with
+// counter_based_random, since the sequential generator cannot start partway
+// through a render. Choices are keyed on the whole address, so squares at
+// any depth make their own choices; see internal::Cantor2dPath.
+template <Image2dWritable ImageT, typename IndexT, RenderStatsCollector StatsT>
+void DrawCantor2dAt(ImageT& dest, const Cantor2dOptions& options, const Cantor2dAddress<IndexT>& address, StatsT& stats) {
+  Cantor2dOptions zoom_options = options;
+  if (options.probability.has_value()) {
+    zoom_options.counter_based_random = true;
+  }
+  int x_digits[Cantor2dAddress<IndexT>::kMaxDepth];
+  int y_digits[Cantor2dAddress<IndexT>::kMaxDepth];
+  IndexT x = address.x;
+  IndexT y = address.y;
+  for (int level = address.depth - 1; level >= 0; level--) {
+    x_digits[level] = int(x % 3);
+    y_digits[level] = int(y % 3);
+    x /= 3;
+    y /= 3;
+  }
+
+  // Every ancestor covers all of dest, so each one either ends the render or
+  // passes it on to the next.
+  Random<double> random(options.seed);
+  internal::Cantor2dPath path = internal::Cantor2dRootPath(options);
+  for (int level = 0; level < address.depth; level++) {
+    if (level >= options.max_iterations) {
+      Fill(dest, 1);
+      return;
+    }
+    stats.Visit(level);
+    int i = x_digits[level];
+    int j = y_digits[level];
+    internal::Cantor2dPath sub_path = internal::Cantor2dSubPath(path, level, i, j);
+    if (!internal::Cantor2dChoose(random, i, j, sub_path, level + 1, zoom_options)) {
+      return;
+    }
+    if (options.draw_all_iterations) {
+      Fill(dest, 1);
+    }
+    path = sub_path;
+  }
+  internal::DrawCantor2d_Root(dest, address.depth, path, Point2(0, 0), Point2(dest.width(), dest.height()), zoom_options, stats);
+}
+
+template <Image2dWritable ImageT, typename IndexT>
+void DrawCantor2dAt(ImageT& dest, const Cantor2dOptions& options, const Cantor2dAddress<IndexT>& address) {
+  NullRenderStats stats;
+  DrawCantor2dAt(dest, options, address, stats);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_CANTOR_CANTOR_ZOOM_HPP__
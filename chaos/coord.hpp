@@ -0,0 +1,162 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_COORD_HPP__
+#define __CHAOS_COORD_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <compare>
+
+namespace chaos {
+
+// A DoubleDouble holds a value as the unevaluated sum of two doubles, giving
+// about 106 bits of precision with plain floating-point arithmetic. It is
+// used as a coordinate type for zooms too deep for double: at a virtual width
+// of 3^50 pixels a double cannot tell neighbouring pixels apart, while a
+// DoubleDouble still resolves a billionth of a pixel.
+class DoubleDouble {
+  public:
+    DoubleDouble() = default;
+    DoubleDouble(double value) : hi_(value), lo_(0) {}
+    // hi and lo must not overlap, i.e. hi + lo rounds to hi.
+    DoubleDouble(double hi, double lo) : hi_(hi), lo_(lo) {}
+
+    explicit operator double() const {
+      return hi_ + lo_;
+    }
+    double hi() const {
+      return hi_;
+    }
+    double lo() const {
+      return lo_;
+    }
+
+    DoubleDouble operator-() const {
+      return DoubleDouble(-hi_, -lo_);
+    }
+    friend DoubleDouble operator+(DoubleDouble a, DoubleDouble b) {
+      auto [s, e] = TwoSum(a.hi_, b.hi_);
+      auto [t, f] = TwoSum(a.lo_, b.lo_);
+      e += t;
+      auto [s2, e2] = QuickTwoSum(s, e);
+      e2 += f;
+      auto [hi, lo] = QuickTwoSum(s2, e2);
+      return DoubleDouble(hi, lo);
+    }
+    friend DoubleDouble operator-(DoubleDouble a, DoubleDouble b) {
+      return a + (-b);
+    }
+    friend DoubleDouble operator*(DoubleDouble a, DoubleDouble b) {
+      double p = a.hi_*b.hi_;
+      double e = std::fma(a.hi_, b.hi_, -p);
+      e += a.hi_*b.lo_ + a.lo_*b.hi_;
+      auto [hi, lo] = QuickTwoSum(p, e);
+      return DoubleDouble(hi, lo);
+    }
+    friend DoubleDouble operator/(DoubleDouble a, DoubleDouble b) {
+      double q1 = a.hi_/b.hi_;
+      DoubleDouble r = a - b*q1;
+      double q2 = r.hi_/b.hi_;
+      r = r - b*q2;
+      double q3 = r.hi_/b.hi_;
+      auto [hi, lo] = QuickTwoSum(q1, q2);
+      return DoubleDouble(hi, lo) + q3;
+    }
+    DoubleDouble& operator+=(DoubleDouble b) {
+      return *this = *this + b;
+    }
+    DoubleDouble& operator-=(DoubleDouble b) {
+      return *this = *this - b;
+    }
+    DoubleDouble& operator*=(DoubleDouble b) {
+      return *this = *this * b;
+    }
+    DoubleDouble& operator/=(DoubleDouble b) {
+      return *this = *this / b;
+    }
+
+    friend bool operator==(DoubleDouble a, DoubleDouble b) {
+      return a.hi_ == b.hi_ && a.lo_ == b.lo_;
+    }
+    friend std::partial_ordering operator<=>(DoubleDouble a, DoubleDouble b) {
+      if (auto order = a.hi_ <=> b.hi_; order != 0) {
+        return order;
+      }
+      return a.lo_ <=> b.lo_;
+    }
+
+    // Returns the largest integer not greater than value.
+    friend DoubleDouble Floor(DoubleDouble value) {
+      double hi = std::floor(value.hi_);
+      if (hi != value.hi_) {
+        return DoubleDouble(hi);
+      }
+      auto [s, e] = QuickTwoSum(hi, std::floor(value.lo_));
+      return DoubleDouble(s, e);
+    }
+
+  private:
+    struct Sum {
+      double s;
+      double e;
+    };
+    // s + e == a + b exactly.
+    static Sum TwoSum(double a, double b) {
+      double s = a + b;
+      double v = s - a;
+      return Sum{s, (a - (s - v)) + (b - v)};
+    }
+    // As TwoSum, for |a| >= |b|.
+    static Sum QuickTwoSum(double a, double b) {
+      double s = a + b;
+      return Sum{s, b - (s - a)};
+    }
+
+    double hi_ = 0;
+    double lo_ = 0;
+};
+
+namespace internal {
+
+// Pixel indices are clamped to +-kPixelIndexLimit, far outside any image,
+// so that offsets added to them cannot overflow.
+constexpr int kPixelIndexLimit = 1 << 30;
+
+// Returns the pixel containing coordinate value. double coordinates are only
+// used for renders of the whole image, where they are non-negative and
+// small, so this is a plain conversion.
+inline int PixelIndex(double value) {
+  return int(value);
+}
+
+// Zoomed coordinates can be negative or far outside the image, so this
+// returns floor(value), clamped to +-kPixelIndexLimit.
+inline int PixelIndex(DoubleDouble value) {
+  DoubleDouble floor = Floor(value);
+  double index = std::clamp(floor.hi() + floor.lo(), double(-kPixelIndexLimit), double(kPixelIndexLimit));
+  return int(index);
+}
+
+}  // namespace internal
+
+// A ZoomWindow1d places a 1-D image in a virtual image of width pixels:
+// pixel x of the image shows virtual pixel x0 + x. Renderers lay the fractal
+// out over the virtual width, so a narrow image with a large virtual width
+// shows a magnified part of it. Virtual sizes and offsets are DoubleDouble,
+// so windows stay exact far past the 2^53 pixels where double runs out.
+struct ZoomWindow1d {
+  DoubleDouble width;
+  DoubleDouble x0 = 0;
+};
+
+// The 2-D counterpart of ZoomWindow1d.
+struct ZoomWindow2d {
+  DoubleDouble width;
+  DoubleDouble height;
+  DoubleDouble x0 = 0;
+  DoubleDouble y0 = 0;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_COORD_HPP__
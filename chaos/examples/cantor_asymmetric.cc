@@ -22,7 +22,7 @@ int main(void) {
     ImageWriteView2d view(img2d, Range2d::FromOffsetAndSize(
       inches_to_pixels(1), inches_to_pixels(1+1.5*i), inches_to_pixels(10), inches_to_pixels(1)));
     BarImageWriter img1d(view);
-    DrawCantor1d(img1d, Cantor1dOptions{.removal_start_ratio=(1.0/4.0), .removal_end_ratio=(2.0/4.0), .max_iterations=i});
+    DrawCantor1d(img1d, Cantor1dOptions{.max_iterations=i, .removal_start_ratio=(1.0/4.0), .removal_end_ratio=(2.0/4.0)});
   }
   WritePgm(img2d, "cantor_asymmetric.pgm");
   return 0;
@@ -21,7 +21,7 @@ int main(void) {
   Image1d<uint8_t> img1d(inches_to_pixels(10));
   for (int i = 0; i < 7; i++) {
     AdditiveWriter1d writer(img1d, 16);
-    DrawCantor1d(writer, Cantor1dOptions{.removal_start_ratio=(1.0/4.0), .removal_end_ratio=(2.0/4.0), .max_iterations=i});
+    DrawCantor1d(writer, Cantor1dOptions{.max_iterations=i, .removal_start_ratio=(1.0/4.0), .removal_end_ratio=(2.0/4.0)});
   }
   ImageWriteView2d view(canvas, Range2d::FromOffsetAndSize(
     inches_to_pixels(1), inches_to_pixels(1), inches_to_pixels(10), inches_to_pixels(10)));
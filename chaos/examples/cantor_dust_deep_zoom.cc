@@ -0,0 +1,40 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+
+#include "coord.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "cantor/cantor.hpp"
+#include "cantor/cantor_zoom.hpp"
+
+using namespace chaos;
+
+constexpr int kSize = 729;
+constexpr int kDepth = 50;
+
+int main(void) {
+  // The square 50 levels down along the path that alternates between the
+  // top-left and bottom-right corners, at 3^50 times the size of the view.
+  Cantor2dAddress<unsigned __int128> address;
+  for (int level = 0; level < kDepth; level++) {
+    int corner = (level % 2) ? 2 : 0;
+    address = address.Child(corner, corner);
+  }
+  Image2d<bool> img(kSize, kSize);
+  DrawCantor2dAt(img, Cantor2dOptions{}, address);
+  WriteBlackWhitePgm(img, "cantor_dust_deep_zoom.pgm");
+
+  // The same zoom, shifted by half a view so that it straddles four squares.
+  // Positions this deep are beyond double but within DoubleDouble.
+  DoubleDouble virtual_size = kSize;
+  DoubleDouble x0 = 0;
+  for (int level = 0; level < kDepth; level++) {
+    virtual_size *= 3;
+    x0 = x0*3 + ((level % 2) ? 2 : 0);
+  }
+  x0 = x0*kSize + kSize/2;
+  Image2d<bool> shifted(kSize, kSize);
+  DrawCantor2d(shifted, Cantor2dOptions{}, ZoomWindow2d{virtual_size, virtual_size, x0, x0});
+  WriteBlackWhitePgm(shifted, "cantor_dust_deep_zoom_shifted.pgm");
+  return 0;
+}
@@ -0,0 +1,29 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+
+#include "tiles.hpp"
+#include "cantor/cantor.hpp"
+
+#include <iostream>
+
+using namespace chaos;
+
+constexpr int kSize = 19683;  // 3^9
+
+int main(void) {
+  // Renders a tile pyramid for a pan/zoom viewer into cantor_dust_tiles/.
+  // Tiles left over from an earlier run are kept.
+  auto draw = [](auto& image) {
+    DrawCantor2d(image, Cantor2dOptions{.max_iterations=9});
+  };
+  TilePyramid pyramid("cantor_dust_tiles", kSize, kSize, draw, TilePyramidOptions{
+      .format = PnmFormat::kPbm,
+      .threads = 0,
+  });
+  Status status = pyramid.RenderAll();
+  if (!status.ok()) {
+    std::cerr << status.message << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+
+#include "bit_image.hpp"
+#include "frames.hpp"
+#include "image.hpp"
+#include "cantor/cantor.hpp"
+
+#include <cstdio>
+
+using namespace chaos;
+
+constexpr int kFrames = 120;
+constexpr int kWidth = 2187;
+constexpr int kHeight = 729;
+
+int main(void) {
+  // The gap slides from the first third of each interval to the last, and
+  // the set deepens by one level every 20 frames.
+  FrameSequenceOptions options{
+    .width = kWidth,
+    .height = kHeight,
+    .num_frames = kFrames,
+    .path_prefix = "cantor_frames/frame_",
+    .format = PnmFormat::kPbm,
+  };
+  FrameSequenceReport report;
+  Status status = RenderFrameSequence<BitImage2d>(options, [](int frame, BitImage2d& canvas) {
+    double t = double(frame)/(kFrames - 1);
+    double start = 0.05 + 0.6*t;
+    BarImageWriter bars(canvas);
+    DrawCantor1d(bars, Cantor1dOptions{.max_iterations = 1 + frame/20, .removal_start_ratio = start, .removal_end_ratio = start + 0.3});
+  }, &report);
+  if (!status.ok()) {
+    std::fprintf(stderr, "%s\n", status.message.c_str());
+    return 1;
+  }
+  auto print = [](const char* stage, const FrameStageReport& r) {
+    std::printf("%-7s %4d frames  %7.1f frames/s  busy %.2f s  waiting %.2f s\n",
+                stage, r.frames, r.frames_per_second(), r.busy_seconds, r.waiting_seconds);
+  };
+  print("render", report.render);
+  print("encode", report.encode);
+  print("write", report.write);
+  std::printf("total   %.2f s\n", report.elapsed_seconds);
+  return 0;
+}
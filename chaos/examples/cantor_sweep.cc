@@ -4,8 +4,7 @@
 #include "image.hpp"
 #include "pgm.hpp"
 #include "cantor/cantor.hpp"
-
-#include <iostream>
+#include "cantor/cantor_sweep.hpp"
 
 using namespace chaos;
 
@@ -20,11 +19,14 @@ int main(void) {
   ImageWriteView2d view(img2d, Range2d::FromOffsetAndSize(
     inches_to_pixels(1), inches_to_pixels(1), inches_to_pixels(10), inches_to_pixels(10)));
 
-  for (int y = 0; y < view.height(); y++) {
+  DrawCantor1dSweep(view, [&](int y) {
+    // The fraction of each interval removed grows from 0 at the top to 1 at
+    // the bottom.
     double ratio = (double)y / (view.height());
-    RowWriter1d row(view, y);
-    DrawCantor1d(row, Cantor1dOptions{.removal_ratio=ratio});
-  }
+    return Cantor1dOptions{
+        .removal_start_ratio=(1.0 - ratio)/2,
+        .removal_end_ratio=(1.0 + ratio)/2};
+  }, /*threads=*/0);
   WritePgm(img2d, "cantor_sweep.pgm");
   return 0;
 }
@@ -1,6 +1,7 @@
 // Copyright (c) 2025 Greg Prisament
 // See LICENSE file.
 
+#include "bit_image.hpp"
 #include "image.hpp"
 #include "pgm.hpp"
 #include "cantor/cantor.hpp"
@@ -16,7 +17,7 @@ int inches_to_pixels(double inches) {
 }
 
 int main(void) {
-  Image2d<bool> img2d(kRes*12, kRes*12);
+  BitImage2d img2d(kRes*12, kRes*12);
 
   ImageWriteView2d view(img2d, Range2d::FromOffsetAndSize(
     (14400-13122)/2, (14400-13122)/2, 13122, 14400-(14400-13122)/2));
@@ -4,6 +4,7 @@
 #include "image.hpp"
 #include "pgm.hpp"
 #include "cantor/cantor.hpp"
+#include "cantor/cantor_fixed.hpp"
 
 #include <iostream>
 
@@ -23,16 +24,7 @@ int main(void) {
       (14400-13122)/2, inches_to_pixels(1+1.5*i), 13122, inches_to_pixels(1)));
     BarImageWriter img1d(view);
     LineWriter1d writer(img1d);
-    DrawMultiGapCantor1d(writer, MultiGapCantor1dOptions{
-        .max_iterations=i,
-        .segments = {
-            Range<double>(0.0, 0.1), 
-            Range<double>(0.2, 0.3), 
-            Range<double>(0.4, 0.5), 
-            Range<double>(0.6, 0.7), 
-            Range<double>(0.8, 0.9), 
-        }
-    });
+    DrawFixedMultiGapCantor1d<kEvenRealsCantor>(writer, FixedCantor1dOptions{.max_iterations=i});
   }
   WriteBlackWhitePgm(img2d, "even_reals.pgm");
   return 0;
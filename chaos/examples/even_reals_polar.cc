@@ -2,10 +2,12 @@
 // See LICENSE file.
 
 #include "image.hpp"
+#include "line.hpp"
 #include "pgm.hpp"
+#include "warp.hpp"
 #include "cantor/cantor.hpp"
 
-#include <iostream>
+#include <cmath>
 
 using namespace chaos;
 
@@ -18,10 +20,14 @@ int inches_to_pixels(double inches) {
 int main(void) {
   Image2d<bool> canvas(kRes*12, kRes*12);
 
+  ImageWriteView2d view(canvas, Range2d::FromOffsetAndSize(
+    inches_to_pixels(1), inches_to_pixels(1), inches_to_pixels(10), inches_to_pixels(10)));
   for (int i = 0; i < 7; i++) {
-    ImageWriteView2d view(canvas, Range2d::FromOffsetAndSize(
-      inches_to_pixels(1), inches_to_pixels(1), inches_to_pixels(10), inches_to_pixels(10)));
-    LineWriterPolarArc writer(view, inches_to_pixels(i/2.0), inches_to_pixels((i+1)/2.0));
+    double inner_r = inches_to_pixels(i/2.0);
+    double outer_r = inches_to_pixels((i+1)/2.0);
+    // One line pixel per pixel of the outer circumference.
+    Image1d<bool> line(int(std::ceil(2*M_PI*outer_r)));
+    LineWriter1d writer(line);
     DrawMultiGapCantor1d(writer, MultiGapCantor1dOptions{
         .max_iterations=i,
         .segments = {
@@ -32,6 +38,7 @@ int main(void) {
             Range<double>(0.8, 0.9),
         }
     });
+    WarpPolar(line, view, PolarWarpOptions{.inner_r = inner_r, .outer_r = outer_r, .threads = 0});
   }
   WriteBlackWhitePgm(canvas, "even_reals_polar.pgm");
   return 0;
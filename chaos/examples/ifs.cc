@@ -0,0 +1,34 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+
+#include "accumulate.hpp"
+#include "ifs.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+
+using namespace chaos;
+
+int main(void) {
+  AccumulationImage2d<uint32_t> fern_counts(1000, 2000);
+  DrawIfs(fern_counts, IfsOptions{
+    .maps = BarnsleyFernIfs(),
+    .window = IfsWindow{.x0 = -2.2, .y0 = 10, .x1 = 2.7, .y1 = 0},
+    .points = 200000000,
+    .threads = 0,
+  });
+  Image2d<uint8_t> fern(fern_counts.width(), fern_counts.height());
+  ToneMap(fern_counts, fern, ToneMapOptions{.curve = ToneCurve::kLog, .threads = 0});
+  WriteBinaryPgm(fern, "barnsley_fern.pgm");
+
+  AccumulationImage2d<uint32_t> triangle_counts(1024, 1024);
+  DrawIfs(triangle_counts, IfsOptions{
+    .maps = SierpinskiTriangleIfs(),
+    .window = IfsWindow{.x0 = 0, .y0 = 1, .x1 = 1, .y1 = 0},
+    .points = 50000000,
+    .threads = 0,
+  });
+  Image2d<uint8_t> triangle(triangle_counts.width(), triangle_counts.height());
+  ToneMap(triangle_counts, triangle, ToneMapOptions{.curve = ToneCurve::kLog, .threads = 0});
+  WriteBinaryPgm(triangle, "sierpinski_triangle.pgm");
+  return 0;
+}
@@ -1,6 +1,7 @@
 // Copyright (c) 2025 Greg Prisament
 // See LICENSE file.
 
+#include "accumulate.hpp"
 #include "image.hpp"
 #include "pgm.hpp"
 #include "cantor/cantor.hpp"
@@ -21,8 +22,9 @@ int main(void) {
 
   ImageWriteView2d view(canvas, Range2d::FromOffsetAndSize(
     inches_to_pixels(1), inches_to_pixels(1), inches_to_pixels(10), inches_to_pixels(10)));
-  AdditiveWriter2d writer(view, 16);
-  DrawCantor2d(writer, Cantor2dOptions{.draw_all_iterations=true, .max_iterations=7, .seed = kSeed, .probability=(4.0/9.0)});
+  AccumulationImage2d<uint16_t> counts(view.width(), view.height());
+  DrawCantor2d(counts, Cantor2dOptions{.max_iterations=7, .seed = kSeed, .probability=(4.0/9.0), .draw_all_iterations=true});
+  ToneMap(counts, view, ToneMapOptions{.curve = ToneCurve::kSaturate, .scale = 16, .threads = 0});
   WritePgm(canvas, "random_cantor_dust_quilt.pgm");
   return 0;
 }
@@ -10,41 +10,36 @@
 
 namespace chaos {
 
+// The Fill functions clip to the image and then use span or rectangle writes
+// where the image provides them.
+
 template <Image1dWritable ImageT>
 void Fill(ImageT& image, typename ImageT::pixel_type p) {
-  for (int x = 0; x < image.width(); x++) {
-    image.write(x, p);
-  }
+  internal::WriteSpan(image, 0, image.width(), p);
 }
 
 template <Image1dWritable ImageT>
 void Fill(ImageT& image, int x0, int x1, typename ImageT::pixel_type p) {
   int x0_ = std::max(0, x0);
-  int x1_ = std::min(image.width(), x1);
-  for (int x = x0_; x < x1_; x++) {
-    image.write(x, p);
+  int x1_ = std::min(int(image.width()), x1);
+  if (x0_ < x1_) {
+    internal::WriteSpan(image, x0_, x1_, p);
   }
 }
 
 template <Image2dWritable ImageT>
 void Fill(ImageT& image, typename ImageT::pixel_type p) {
-  for (int y = 0; y < image.height(); y++) {
-    for (int x = 0; x < image.width(); x++) {
-      image.write(x, y, p);
-    }
-  }
+  internal::FillRect(image, Range2d(image.width(), image.height()), p);
 }
 
 template <Image2dWritable ImageT>
 void Fill(ImageT& image, Range2d range, typename ImageT::pixel_type p) {
   int x0 = std::max(0, range.x0);
   int y0 = std::max(0, range.y0);
-  int x1 = std::min(image.width(), range.x1);
-  int y1 = std::min(image.height(), range.y1);
-  for (int y = y0; y < y1; y++) {
-    for (int x = x0; x < x1; x++) {
-      image.write(x, y, p);
-    }
+  int x1 = std::min(int(image.width()), range.x1);
+  int y1 = std::min(int(image.height()), range.y1);
+  if (x0 < x1 && y0 < y1) {
+    internal::FillRect(image, Range2d(x0, y0, x1, y1), p);
   }
 }
 
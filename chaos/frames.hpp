@@ -0,0 +1,278 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_FRAMES_HPP__
+#define __CHAOS_FRAMES_HPP__
+
+#include "fill.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "status.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace chaos {
+
+// A frame sequence renders an animation, one image file per frame, as a
+// three-stage pipeline: frames are rendered on the calling thread, encoded
+// to PNM on a second thread and written out on a third, so that frame N+1
+// renders while frame N is encoded and frame N-1 is written. Canvases are
+// allocated once and reused, and each stage hands frames to the next through
+// a bounded queue, so a slow stage holds the others back rather than letting
+// frames pile up in memory.
+
+struct FrameSequenceOptions {
+  int width = 0;
+  int height = 0;
+  int num_frames = 0;
+  // Frame i is written to path_prefix, then i padded to five digits, then
+  // ".pgm" or ".pbm". Missing directories are created.
+  std::string path_prefix = "frame_";
+  PnmFormat format = PnmFormat::kPgm;
+  // Number of canvases, which bounds the frames that are rendered but not
+  // yet encoded. Two let rendering and encoding overlap.
+  int canvases = 2;
+  // Number of encoded frames that may wait to be written.
+  int queue_depth = 2;
+};
+
+// How one stage of a frame sequence spent its time.
+struct FrameStageReport {
+  int frames = 0;
+  // Time spent working on frames.
+  double busy_seconds = 0;
+  // Time spent waiting for the stage before it, or for room in the stage
+  // after it.
+  double waiting_seconds = 0;
+  // The rate the stage could sustain on its own.
+  double frames_per_second() const {
+    return busy_seconds > 0 ? frames/busy_seconds : 0;
+  }
+};
+
+struct FrameSequenceReport {
+  FrameStageReport render;
+  FrameStageReport encode;
+  FrameStageReport write;
+  double elapsed_seconds = 0;
+};
+
+namespace internal {
+
+// A queue of at most capacity items, shared between threads. Push blocks
+// while the queue is full, and Pop while it is empty. Once closed, Push
+// discards items and Pop drains what is left, then returns nullopt.
+template <typename T>
+class BoundedQueue {
+  public:
+    explicit BoundedQueue(int capacity) : capacity_(std::max(1, capacity)) {}
+
+    void Push(T item) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_full_.wait(lock, [this] { return closed_ || int(items_.size()) < capacity_; });
+      if (closed_) {
+        return;
+      }
+      items_.push_back(std::move(item));
+      not_empty_.notify_one();
+    }
+    std::optional<T> Pop() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+      if (items_.empty()) {
+        return std::nullopt;
+      }
+      T item = std::move(items_.front());
+      items_.pop_front();
+      not_full_.notify_one();
+      return item;
+    }
+    void Close() {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+      not_full_.notify_all();
+      not_empty_.notify_all();
+    }
+
+  private:
+    int capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+    std::deque<T> items_;
+    bool closed_ = false;
+};
+
+// Times the phases of a stage into a FrameStageReport.
+class StageTimer {
+  public:
+    explicit StageTimer(FrameStageReport& report) : report_(report), start_(Clock::now()) {}
+    // Ends a period of waiting and starts one of work.
+    void Busy() {
+      report_.waiting_seconds += Lap();
+    }
+    // Ends a period of work on a frame and starts one of waiting.
+    void Done() {
+      report_.busy_seconds += Lap();
+      report_.frames++;
+    }
+    // Ends a period of work that did not finish a frame.
+    void Idle() {
+      report_.busy_seconds += Lap();
+    }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    double Lap() {
+      Clock::time_point now = Clock::now();
+      double seconds = std::chrono::duration<double>(now - start_).count();
+      start_ = now;
+      return seconds;
+    }
+    FrameStageReport& report_;
+    Clock::time_point start_;
+};
+
+inline std::string FramePath(const FrameSequenceOptions& options, int frame) {
+  char number[16];
+  std::snprintf(number, sizeof(number), "%05d", frame);
+  return options.path_prefix + number + (options.format == PnmFormat::kPbm ? ".pbm" : ".pgm");
+}
+
+// Encodes image as a complete binary PNM file.
+template <Image2dReadable ImageT>
+void EncodePnm(const ImageT& image, PnmFormat format, std::vector<uint8_t>& out) {
+  std::string header = (format == PnmFormat::kPbm)
+      ? PnmHeader("P4", image.width(), image.height(), 0)
+      : PnmHeader("P5", image.width(), image.height(), 255);
+  size_t row_bytes = (format == PnmFormat::kPbm) ? PbmRowBytes(image.width()) : size_t(image.width());
+  out.resize(header.size() + row_bytes*image.height());
+  std::copy(header.begin(), header.end(), out.begin());
+  uint8_t* rows = out.data() + header.size();
+  for (int y = 0; y < image.height(); y++) {
+    if (format == PnmFormat::kPbm) {
+      EncodePbmRow(image, y, rows + size_t(y)*row_bytes);
+    } else {
+      EncodePgmRow(image, y, rows + size_t(y)*row_bytes);
+    }
+  }
+}
+
+}  // namespace internal
+
+// Renders options.num_frames frames with render(frame, canvas) and writes
+// each to its file. Canvases are ImageT(width, height), cleared to
+// pixel_type{} before each frame. render runs on the calling thread, one
+// frame at a time, and may use threads of its own. Stops at the first error
+// and returns it. If report is not null, it receives the time each stage
+// spent working and waiting.
+template <Image2dReadWritable ImageT, typename RenderFn>
+Status RenderFrameSequence(const FrameSequenceOptions& options, RenderFn render, FrameSequenceReport* report = nullptr) {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point start = Clock::now();
+  FrameSequenceReport local_report;
+  FrameSequenceReport& stats = report ? *report : local_report;
+  stats = FrameSequenceReport{};
+
+  std::error_code error;
+  std::filesystem::path directory = std::filesystem::path(internal::FramePath(options, 0)).parent_path();
+  if (!directory.empty()) {
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+      return Status{error.value(), "creating " + directory.string() + ": " + error.message()};
+    }
+  }
+
+  struct Rendered {
+    int frame;
+    int canvas;
+  };
+  struct Encoded {
+    int frame;
+    std::vector<uint8_t> bytes;
+  };
+  int num_canvases = std::max(1, options.canvases);
+  std::vector<ImageT> canvases;
+  canvases.reserve(num_canvases);
+  internal::BoundedQueue<int> free_canvases(num_canvases);
+  for (int i = 0; i < num_canvases; i++) {
+    canvases.emplace_back(options.width, options.height);
+    free_canvases.Push(i);
+  }
+  internal::BoundedQueue<Rendered> rendered(num_canvases);
+  internal::BoundedQueue<Encoded> encoded(options.queue_depth);
+  Status status{0, ""};
+  std::atomic<bool> failed{false};
+
+  std::thread encoder([&] {
+    internal::StageTimer timer(stats.encode);
+    while (std::optional<Rendered> item = rendered.Pop()) {
+      timer.Busy();
+      Encoded out{item->frame, {}};
+      internal::EncodePnm(canvases[item->canvas], options.format, out.bytes);
+      free_canvases.Push(item->canvas);
+      timer.Done();
+      encoded.Push(std::move(out));
+    }
+    encoded.Close();
+  });
+  std::thread writer([&] {
+    internal::StageTimer timer(stats.write);
+    while (std::optional<Encoded> item = encoded.Pop()) {
+      timer.Busy();
+      std::string path = internal::FramePath(options, item->frame);
+      std::ofstream outfile(path, std::ios::binary);
+      outfile.write(reinterpret_cast<const char*>(item->bytes.data()), item->bytes.size());
+      outfile.close();
+      if (!outfile) {
+        status = Status{EIO, "error writing " + path};
+        failed = true;
+        // Unblocks the other stages, which then stop.
+        encoded.Close();
+        rendered.Close();
+        free_canvases.Close();
+        timer.Idle();
+        break;
+      }
+      timer.Done();
+    }
+  });
+
+  {
+    internal::StageTimer timer(stats.render);
+    for (int frame = 0; frame < options.num_frames && !failed; frame++) {
+      std::optional<int> canvas = free_canvases.Pop();
+      if (!canvas) {
+        break;
+      }
+      timer.Busy();
+      Fill(canvases[*canvas], typename ImageT::pixel_type{});
+      render(frame, canvases[*canvas]);
+      timer.Done();
+      rendered.Push(Rendered{frame, *canvas});
+    }
+  }
+  rendered.Close();
+  encoder.join();
+  writer.join();
+  stats.elapsed_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  return status;
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_FRAMES_HPP__
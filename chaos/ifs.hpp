@@ -0,0 +1,286 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_IFS_HPP__
+#define __CHAOS_IFS_HPP__
+
+#include "accumulate.hpp"
+#include "image.hpp"
+#include "rand.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace chaos {
+
+// An iterated function system (IFS) is a set of contractive affine maps. Its
+// attractor is drawn by the chaos game: starting anywhere, repeatedly apply a
+// map chosen at random and plot the points visited.
+
+// Maps (x, y) to (a*x + b*y + e, c*x + d*y + f). The chaos game picks it with
+// probability proportional to probability.
+struct AffineMap {
+  double a = 1;
+  double b = 0;
+  double c = 0;
+  double d = 1;
+  double e = 0;
+  double f = 0;
+  double probability = 1;
+};
+
+// The region of the plane drawn onto the image: x0 maps to the left edge, x1
+// to the right, y0 to the top and y1 to the bottom. Use y0 > y1 for y up.
+struct IfsWindow {
+  double x0 = 0;
+  double y0 = 0;
+  double x1 = 1;
+  double y1 = 1;
+};
+
+struct IfsOptions {
+  std::vector<AffineMap> maps;
+  IfsWindow window;
+  // Number of points to plot, not counting warm-up iterations.
+  uint64_t points = 1000000;
+  // Iterations run on each chain before it starts plotting, so that it has
+  // converged onto the attractor.
+  int warmup = 20;
+  uint64_t seed = 0;
+  // Number of threads to render with; 0 uses every hardware thread. Threads
+  // count hits into the image a band of rows at a time, so they need no
+  // histograms of their own.
+  int threads = 1;
+};
+
+// The three half-size corner maps whose attractor is the Sierpinski triangle,
+// within [0, 1] x [0, 1].
+inline std::vector<AffineMap> SierpinskiTriangleIfs() {
+  return {
+    {.a = 0.5, .d = 0.5, .e = 0.0, .f = 0.0},
+    {.a = 0.5, .d = 0.5, .e = 0.5, .f = 0.0},
+    {.a = 0.5, .d = 0.5, .e = 0.25, .f = 0.5},
+  };
+}
+
+// Barnsley's fern, within x in [-2.2, 2.7], y in [0, 10].
+inline std::vector<AffineMap> BarnsleyFernIfs() {
+  return {
+    {.a = 0.0, .b = 0.0, .c = 0.0, .d = 0.16, .e = 0.0, .f = 0.0, .probability = 0.01},
+    {.a = 0.85, .b = 0.04, .c = -0.04, .d = 0.85, .e = 0.0, .f = 1.6, .probability = 0.85},
+    {.a = 0.2, .b = -0.26, .c = 0.23, .d = 0.22, .e = 0.0, .f = 1.6, .probability = 0.07},
+    {.a = -0.15, .b = 0.28, .c = 0.26, .d = 0.24, .e = 0.0, .f = 0.44, .probability = 0.07},
+  };
+}
+
+namespace internal {
+
+// Chains iterated side by side within a stream. Their steps are independent,
+// so each step is a loop over chains, which the compiler vectorizes. Each
+// chain draws from its own lane of a LaneRandom.
+constexpr int kIfsChains = 16;
+// Points plotted per stream. The points are split into streams of this many,
+// each with its own chains, seeded from its own CounterRandom stream, and
+// threads take streams in any order. Counts are sums of hits, so the result
+// only depends on the streams, not on the number of threads.
+constexpr uint64_t kIfsStreamPoints = uint64_t(1) << 22;
+// With threads, the image is split into at most this many bands of rows, each
+// with its own lock, and hits are counted into dest a bucket at a time.
+constexpr int kIfsBands = 64;
+// Hits a thread holds for each band before it takes the band's lock and
+// counts them.
+constexpr int kIfsBucketHits = 1024;
+
+// Counts a hit. Counts stick at the largest CountT.
+template <typename CountT>
+void IfsCountHit(CountT& count) {
+  count += (count != std::numeric_limits<CountT>::max());
+}
+
+// Runs stream `stream` of the chaos game, calling plot(x, y) for each point
+// that lands in the width x height image.
+template <typename PlotFn>
+void IfsStream(const IfsOptions& options, const std::vector<double>& cumulative, const CounterRandom& random,
+               uint64_t stream, uint64_t points, int width, int height, PlotFn&& plot) {
+  constexpr int L = kIfsChains;
+  const std::vector<AffineMap>& maps = options.maps;
+  int num_maps = maps.size();
+  double scale_x = width/(options.window.x1 - options.window.x0);
+  double scale_y = height/(options.window.y1 - options.window.y0);
+  double x[L];
+  double y[L];
+  uint32_t bits[L];
+  double u[L];
+  int choice[L];
+  LaneRandom<L> lanes(random, stream);
+  // Chains start at random points in the unit square.
+  lanes.Next(bits);
+  for (int l = 0; l < L; l++) {
+    x[l] = bits[l]*0x1.0p-32;
+  }
+  lanes.Next(bits);
+  for (int l = 0; l < L; l++) {
+    y[l] = bits[l]*0x1.0p-32;
+  }
+  uint64_t steps = options.warmup + (points + L - 1)/L;
+  uint64_t plotted = 0;
+  for (uint64_t step = 0; step < steps; step++) {
+    // 32 bits are plenty to choose a map with.
+    lanes.Next(bits);
+    for (int l = 0; l < L; l++) {
+      u[l] = bits[l]*0x1.0p-32;
+      choice[l] = 0;
+    }
+    for (int m = 0; m + 1 < num_maps; m++) {
+      for (int l = 0; l < L; l++) {
+        choice[l] += (u[l] >= cumulative[m]);
+      }
+    }
+    for (int l = 0; l < L; l++) {
+      const AffineMap& map = maps[choice[l]];
+      double next_x = map.a*x[l] + map.b*y[l] + map.e;
+      double next_y = map.c*x[l] + map.d*y[l] + map.f;
+      x[l] = next_x;
+      y[l] = next_y;
+    }
+    if (step < uint64_t(options.warmup)) {
+      continue;
+    }
+    int count = int(std::min<uint64_t>(L, points - plotted));
+    plotted += count;
+    for (int l = 0; l < count; l++) {
+      double px = (x[l] - options.window.x0)*scale_x;
+      double py = (y[l] - options.window.y0)*scale_y;
+      // Also rejects NaN, from chains that diverged.
+      if (px >= 0 && px < width && py >= 0 && py < height) {
+        plot(int(px), int(py));
+      }
+    }
+  }
+}
+
+// A pixel hit by a point.
+struct IfsHit {
+  int x;
+  int y;
+};
+
+// Counts hits into dest from several threads. Each thread holds a bucket of
+// hits per band of rows and counts a full bucket into its band under the
+// band's lock, so memory is bounded by the buckets rather than a histogram
+// per thread.
+template <typename CountT>
+class IfsBandedCounter {
+  public:
+    explicit IfsBandedCounter(AccumulationImage2d<CountT>& dest)
+        : dest_(dest),
+          band_rows_((dest.height() + kIfsBands - 1)/kIfsBands),
+          num_bands_((dest.height() + band_rows_ - 1)/band_rows_),
+          locks_(num_bands_) {}
+
+    // One thread's buckets.
+    class Buckets {
+      public:
+        explicit Buckets(IfsBandedCounter& counter) : counter_(counter), buckets_(counter.num_bands_) {
+          for (std::vector<IfsHit>& bucket : buckets_) {
+            bucket.reserve(kIfsBucketHits);
+          }
+        }
+        ~Buckets() {
+          for (int band = 0; band < counter_.num_bands_; band++) {
+            counter_.Count(band, buckets_[band]);
+          }
+        }
+        void Add(int x, int y) {
+          int band = y/counter_.band_rows_;
+          std::vector<IfsHit>& bucket = buckets_[band];
+          bucket.push_back(IfsHit{x, y});
+          if (int(bucket.size()) == kIfsBucketHits) {
+            counter_.Count(band, bucket);
+          }
+        }
+      private:
+        IfsBandedCounter& counter_;
+        std::vector<std::vector<IfsHit>> buckets_;
+    };
+
+  private:
+    // Counts bucket into dest and empties it.
+    void Count(int band, std::vector<IfsHit>& bucket) {
+      if (bucket.empty()) {
+        return;
+      }
+      std::lock_guard<std::mutex> lock(locks_[band]);
+      for (const IfsHit& hit : bucket) {
+        IfsCountHit(dest_.row(hit.y)[hit.x]);
+      }
+      bucket.clear();
+    }
+
+    AccumulationImage2d<CountT>& dest_;
+    int band_rows_;
+    int num_bands_;
+    std::vector<std::mutex> locks_;
+};
+
+}  // namespace internal
+
+// Plays the chaos game on options.maps, adding the number of points that land
+// in each pixel to dest. Tone-map dest to get an image for the PGM writers.
+// Counts stick at the largest CountT. They depend on options.seed and
+// options.points, not on the number of threads. Threads count straight into
+// dest, so a render needs no memory in proportion to the image beyond dest.
+template <typename CountT>
+void DrawIfs(AccumulationImage2d<CountT>& dest, const IfsOptions& options) {
+  if (options.maps.empty() || dest.width() <= 0 || dest.height() <= 0 || options.points == 0) {
+    return;
+  }
+  std::vector<double> cumulative;
+  double total = 0;
+  for (const AffineMap& map : options.maps) {
+    total += std::max(0.0, map.probability);
+    cumulative.push_back(total);
+  }
+  if (!(total > 0)) {
+    return;
+  }
+  for (double& c : cumulative) {
+    c /= total;
+  }
+  CounterRandom random(options.seed);
+  uint64_t num_streams = (options.points + internal::kIfsStreamPoints - 1)/internal::kIfsStreamPoints;
+  auto stream_points = [&](uint64_t stream) {
+    return std::min(internal::kIfsStreamPoints, options.points - stream*internal::kIfsStreamPoints);
+  };
+
+  if (options.threads == 1 || num_streams == 1) {
+    for (uint64_t stream = 0; stream < num_streams; stream++) {
+      internal::IfsStream(options, cumulative, random, stream, stream_points(stream), dest.width(), dest.height(),
+                          [&](int x, int y) { internal::IfsCountHit(dest.row(y)[x]); });
+    }
+    return;
+  }
+  ThreadPool pool(options.threads);
+  int workers = int(std::min<uint64_t>(pool.num_threads(), num_streams));
+  internal::IfsBandedCounter<CountT> counter(dest);
+  std::atomic<uint64_t> next_stream{0};
+  TaskGroup group;
+  for (int w = 0; w < workers; w++) {
+    pool.Run(group, [&] {
+      typename internal::IfsBandedCounter<CountT>::Buckets buckets(counter);
+      for (uint64_t stream = next_stream++; stream < num_streams; stream = next_stream++) {
+        internal::IfsStream(options, cumulative, random, stream, stream_points(stream), dest.width(), dest.height(),
+                            [&](int x, int y) { buckets.Add(x, y); });
+      }
+    });
+  }
+  pool.Wait(group);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_IFS_HPP__
@@ -5,8 +5,10 @@
 
 #include "range.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <concepts>
+#include <type_traits>
 #include <vector>
 #include <iostream>
 
@@ -44,6 +46,152 @@ concept Image2dWritable = requires(ImageT i, typename ImageT::pixel_type p) {
 template <typename ImageT>
 concept Image2dReadWritable = Image2dReadable<ImageT> && Image2dWritable<ImageT>;
 
+// Concept Image1dSpanWritable is satisfied by 1-D images that can set a run
+// of pixels [x0, x1) in one call. Spans must lie within the image.
+template <typename ImageT>
+concept Image1dSpanWritable = Image1dWritable<ImageT> && requires(ImageT i, typename ImageT::pixel_type p) {
+  i.write_span(0, 0, p);
+};
+
+// Concept Image2dSpanWritable is satisfied by 2-D images that can set a run
+// of pixels [x0, x1) of row y in one call. Spans must lie within the image.
+template <typename ImageT>
+concept Image2dSpanWritable = Image2dWritable<ImageT> && requires(ImageT i, typename ImageT::pixel_type p) {
+  i.write_span(0, 0, 0, p);
+};
+
+// Concept Image2dRectFillable is satisfied by 2-D images that can set a
+// rectangle of pixels in one call. Rectangles must lie within the image.
+template <typename ImageT>
+concept Image2dRectFillable = Image2dWritable<ImageT> && requires(ImageT i, typename ImageT::pixel_type p) {
+  i.fill_rect(Range2d(0, 0), p);
+};
+
+// Concept Image2dClipped is satisfied by images that only keep writes within
+// clip_range(); writes elsewhere are accepted but discarded. Renderers can use
+// it to skip work that would not be visible.
+template <typename ImageT>
+concept Image2dClipped = Image2dWritable<ImageT> && requires(const ImageT i) {
+  {i.clip_range()} -> std::convertible_to<Range2d>;
+};
+
+// Concept Image1dClipped is the 1-D counterpart of Image2dClipped. Writers
+// that draw onto 2-D images report the columns that can show anything.
+template <typename ImageT>
+concept Image1dClipped = requires(const ImageT i) {
+  {i.clip_range()} -> std::convertible_to<Range<int>>;
+};
+
+// Concept Image2dContiguous is satisfied by images whose rows are stored
+// contiguously in memory, one pixel_type per pixel.
+template <typename ImageT>
+concept Image2dContiguous = Image2dReadable<ImageT> && requires(const ImageT i) {
+  {i.row(0)} -> std::convertible_to<const typename ImageT::pixel_type*>;
+};
+
+// Concept Image2dBitPacked is satisfied by bilevel images that store each row
+// as 64-bit words, with pixel x held in bit (x % 64) of word (x / 64).
+template <typename ImageT>
+concept Image2dBitPacked = Image2dReadable<ImageT> && requires(const ImageT i) {
+  {i.row_words(0)} -> std::convertible_to<const uint64_t*>;
+};
+
+// A run of pixels [x0, x1) with the same value.
+template <typename PixelT>
+struct PixelRun {
+  int x0;
+  int x1;
+  PixelT value;
+  bool operator==(const PixelRun&) const = default;
+};
+
+// Concept Image2dRunLength is satisfied by images that store each row as
+// runs sorted by x0, with pixels outside every run equal to pixel_type{}.
+template <typename ImageT>
+concept Image2dRunLength = Image2dReadable<ImageT> && requires(const ImageT i) {
+  {i.row_runs(0)} -> std::convertible_to<const std::vector<PixelRun<typename ImageT::pixel_type>>&>;
+};
+
+namespace internal {
+
+// Sets pixels [x0, x1) of image, which must lie within it, using the widest
+// write the image supports.
+template <Image1dWritable ImageT>
+void WriteSpan(ImageT& image, int x0, int x1, typename ImageT::pixel_type p) {
+  if constexpr (Image1dSpanWritable<ImageT>) {
+    image.write_span(x0, x1, p);
+  } else {
+    for (int x = x0; x < x1; x++) {
+      image.write(x, p);
+    }
+  }
+}
+
+template <Image2dWritable ImageT>
+void WriteSpan(ImageT& image, int x0, int x1, int y, typename ImageT::pixel_type p) {
+  if constexpr (Image2dSpanWritable<ImageT>) {
+    image.write_span(x0, x1, y, p);
+  } else {
+    for (int x = x0; x < x1; x++) {
+      image.write(x, y, p);
+    }
+  }
+}
+
+// Sets the pixels of range, which must lie within image.
+template <Image2dWritable ImageT>
+void FillRect(ImageT& image, Range2d range, typename ImageT::pixel_type p) {
+  if (range.x0 >= range.x1) {
+    return;
+  }
+  if constexpr (Image2dRectFillable<ImageT>) {
+    image.fill_rect(range, p);
+  } else {
+    for (int y = range.y0; y < range.y1; y++) {
+      WriteSpan(image, range.x0, range.x1, y, p);
+    }
+  }
+}
+
+}  // namespace internal
+
+// Returns the part of image where writes are kept.
+template <Image2dWritable ImageT>
+Range2d ClipRange(const ImageT& image) {
+  Range2d bounds(image.width(), image.height());
+  if constexpr (Image2dClipped<ImageT>) {
+    return Intersect(bounds, image.clip_range());
+  } else {
+    return bounds;
+  }
+}
+
+// Returns the part of a 1-D image, or a writer or line drawer, where writes
+// are kept.
+template <typename ImageT>
+Range<int> ClipRange1d(const ImageT& image) {
+  int width = image.width();
+  if constexpr (Image1dClipped<ImageT>) {
+    Range<int> clip = image.clip_range();
+    int x0 = std::max(0, clip.x0);
+    return Range<int>(x0, std::max(x0, std::min(width, clip.x1)));
+  } else {
+    return Range<int>(0, width);
+  }
+}
+
+namespace internal {
+// Returns the columns of image in which anything is kept.
+template <Image2dWritable ImageT>
+Range<int> VisibleColumns(const ImageT& image) {
+  Range2d clip = ClipRange(image);
+  if (clip.empty()) {
+    return Range<int>(0, 0);
+  }
+  return Range<int>(clip.x0, clip.x1);
+}
+}  // namespace internal
+
 template <typename PixelT>
 class Image1d {
   public:
@@ -52,6 +200,9 @@ class Image1d {
     void write(int x, pixel_type value) {
       data_[x] = value;
     }
+    void write_span(int x0, int x1, pixel_type value) {
+      std::fill(data_.begin() + x0, data_.begin() + x1, value);
+    }
     pixel_type read(int x) const {
       return data_[x];
     }
@@ -70,9 +221,31 @@ class Image2d {
     void write(int x, int y, pixel_type value) {
       data_[y*width_ + x] = value;
     }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      auto row = data_.begin() + size_t(y)*width_;
+      std::fill(row + x0, row + x1, value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      if (range.x0 == 0 && range.x1 == width_) {
+        // Full-width rows are contiguous, so the whole rectangle is one run.
+        std::fill(data_.begin() + size_t(range.y0)*width_, data_.begin() + size_t(range.y1)*width_, value);
+        return;
+      }
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
     pixel_type read(int x, int y) const {
       return data_[y*width_ + x];
     }
+    // Rows are only addressable when pixels are not bit-packed, which rules
+    // out std::vector<bool>.
+    pixel_type* row(int y) requires (!std::is_same_v<PixelT, bool>) {
+      return data_.data() + size_t(y)*width_;
+    }
+    const pixel_type* row(int y) const requires (!std::is_same_v<PixelT, bool>) {
+      return data_.data() + size_t(y)*width_;
+    }
     int width() const {
       return width_;
     }
@@ -85,6 +258,29 @@ class Image2d {
     std::vector<pixel_type> data_;
 };
 
+// A NullImage2d has a size but discards everything written to it.
+template <typename PixelT>
+class NullImage2d {
+  public:
+    using pixel_type = PixelT;
+    NullImage2d(int width, int height) : width_(width), height_(height) {}
+    void write(int, int, pixel_type) {}
+    void write_span(int, int, int, pixel_type) {}
+    void fill_rect(Range2d, pixel_type) {}
+    pixel_type read(int, int) const {
+      return pixel_type();
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    int width_;
+    int height_;
+};
+
 template <Image2dWritable UnderlyingImageT>
 class ImageWriteView2d {
   public:
@@ -95,9 +291,23 @@ class ImageWriteView2d {
     void write(int x, int y, pixel_type value) {
       underlying_->write(x + subrange_.x0, y + subrange_.y0, value);
     }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      internal::WriteSpan(*underlying_, x0 + subrange_.x0, x1 + subrange_.x0, y + subrange_.y0, value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      internal::FillRect(*underlying_, Range2d(
+          range.x0 + subrange_.x0, range.y0 + subrange_.y0,
+          range.x1 + subrange_.x0, range.y1 + subrange_.y0), value);
+    }
     pixel_type read(int x, int y) const {
       return underlying_->read(x + subrange_.x0, y + subrange_.y0);
     }
+    Range2d clip_range() const {
+      Range2d clip = ClipRange(*underlying_);
+      return Intersect(Range2d(width(), height()), Range2d(
+          clip.x0 - subrange_.x0, clip.y0 - subrange_.y0,
+          clip.x1 - subrange_.x0, clip.y1 - subrange_.y0));
+    }
     int width() const {
       return subrange_.width();
     }
@@ -109,6 +319,109 @@ class ImageWriteView2d {
     Range2d subrange_;
 };
 
+// A VirtualImageView2d presents underlying as a window onto a larger virtual
+// image of width x height pixels. Underlying pixel (0, 0) shows virtual pixel
+// (offset_x, offset_y), and writes that land outside underlying are
+// discarded. clip_range() reports the window, so renderers that cull against
+// it do work in proportion to what is visible rather than to the size of the
+// virtual image. This is how to draw a zoomed-in part of a fractal.
+template <Image2dWritable UnderlyingImageT>
+class VirtualImageView2d {
+  public:
+    using underlying_type = UnderlyingImageT;
+    using pixel_type = typename UnderlyingImageT::pixel_type;
+    VirtualImageView2d(underlying_type& underlying, int width, int height, int offset_x, int offset_y)
+        : underlying_(&underlying), width_(width), height_(height), offset_x_(offset_x), offset_y_(offset_y) {}
+
+    void write(int x, int y, pixel_type value) {
+      x -= offset_x_;
+      y -= offset_y_;
+      if (x >= 0 && x < underlying_->width() && y >= 0 && y < underlying_->height()) {
+        underlying_->write(x, y, value);
+      }
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      fill_rect(Range2d(x0, y, x1, y + 1), value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      Range2d visible = Intersect(Range2d(
+          range.x0 - offset_x_, range.y0 - offset_y_,
+          range.x1 - offset_x_, range.y1 - offset_y_), Range2d(underlying_->width(), underlying_->height()));
+      if (!visible.empty()) {
+        internal::FillRect(*underlying_, visible, value);
+      }
+    }
+    pixel_type read(int x, int y) const requires Image2dReadable<underlying_type> {
+      x -= offset_x_;
+      y -= offset_y_;
+      if (x < 0 || x >= underlying_->width() || y < 0 || y >= underlying_->height()) {
+        return pixel_type();
+      }
+      return underlying_->read(x, y);
+    }
+    Range2d clip_range() const {
+      Range2d clip = ClipRange(*underlying_);
+      return Intersect(Range2d(width_, height_), Range2d(
+          clip.x0 + offset_x_, clip.y0 + offset_y_,
+          clip.x1 + offset_x_, clip.y1 + offset_y_));
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    underlying_type* underlying_;
+    int width_;
+    int height_;
+    int offset_x_;
+    int offset_y_;
+};
+
+// The 1-D counterpart of VirtualImageView2d.
+template <Image1dWritable UnderlyingImageT>
+class VirtualImageView1d {
+  public:
+    using underlying_type = UnderlyingImageT;
+    using pixel_type = typename UnderlyingImageT::pixel_type;
+    VirtualImageView1d(underlying_type& underlying, int width, int offset_x)
+        : underlying_(&underlying), width_(width), offset_x_(offset_x) {}
+
+    void write(int x, pixel_type value) {
+      x -= offset_x_;
+      if (x >= 0 && x < underlying_->width()) {
+        underlying_->write(x, value);
+      }
+    }
+    void write_span(int x0, int x1, pixel_type value) {
+      x0 = std::max(x0 - offset_x_, 0);
+      x1 = std::min(x1 - offset_x_, int(underlying_->width()));
+      if (x0 < x1) {
+        internal::WriteSpan(*underlying_, x0, x1, value);
+      }
+    }
+    pixel_type read(int x) const requires Image1dReadable<underlying_type> {
+      x -= offset_x_;
+      if (x < 0 || x >= underlying_->width()) {
+        return pixel_type();
+      }
+      return underlying_->read(x);
+    }
+    Range<int> clip_range() const {
+      Range<int> clip = ClipRange1d(*underlying_);
+      int x0 = std::max(0, clip.x0 + offset_x_);
+      return Range<int>(x0, std::max(x0, std::min(width_, clip.x1 + offset_x_)));
+    }
+    int width() const {
+      return width_;
+    }
+  private:
+    underlying_type* underlying_;
+    int width_;
+    int offset_x_;
+};
+
 template <Image2dWritable UnderlyingImageT, typename PixelT>
 class PlotImageWriter {
   public:
@@ -116,11 +429,18 @@ class PlotImageWriter {
     using pixel_type = PixelT;
     PlotImageWriter(underlying_type& underlying, typename underlying_type::pixel_type value) : underlying_(&underlying) , value_(value) {}
     void write(int x, pixel_type value) {
-      for (int y = 0; y < int(value); y++) {
-        SafeWrite(*underlying_, x, y, value_);
-      }
+      Fill(*underlying_, Range2d(x, 0, x+1, int(value)), value_);
     }
-    int width() {
+    underlying_type& underlying() const {
+      return *underlying_;
+    }
+    typename underlying_type::pixel_type value() const {
+      return value_;
+    }
+    Range<int> clip_range() const {
+      return internal::VisibleColumns(*underlying_);
+    }
+    int width() const {
       return underlying_->width();
     }
   private:
@@ -139,7 +459,14 @@ class BarImageWriter {
         underlying_->write(x, y, value);
       }
     }
-    int width() {
+    // Writes the bars for [x0, x1) a row at a time.
+    void write_span(int x0, int x1, pixel_type value) {
+      internal::FillRect(*underlying_, Range2d(x0, 0, x1, underlying_->height()), value);
+    }
+    Range<int> clip_range() const {
+      return internal::VisibleColumns(*underlying_);
+    }
+    int width() const {
       return underlying_->width();
     }
   private:
@@ -156,6 +483,16 @@ class RowWriter1d {
     void write(int x, pixel_type value) {
         underlying_->write(x, y_, value);
     }
+    void write_span(int x0, int x1, pixel_type value) {
+        internal::WriteSpan(*underlying_, x0, x1, y_, value);
+    }
+    Range<int> clip_range() const {
+      Range2d clip = ClipRange(*underlying_);
+      if (y_ < clip.y0 || y_ >= clip.y1) {
+        return Range<int>(0, 0);
+      }
+      return Range<int>(clip.x0, clip.x1);
+    }
     int width() const {
       return underlying_->width();
     }
@@ -176,7 +513,9 @@ class AdditiveWriter1d {
     void write(int x, pixel_type value) {
         pixel_type p = underlying_->read(x);
         underlying_->write(x, p+amount_);
-        std::cout << "writing " << (int)p+amount_ << std::endl;
+    }
+    Range<int> clip_range() const {
+      return ClipRange1d(*underlying_);
     }
     int width() const {
       return underlying_->width();
@@ -192,13 +531,16 @@ class AdditiveWriter2d {
     using underlying_type = UnderlyingImageT;
     using pixel_type = typename underlying_type::pixel_type;
     AdditiveWriter2d(underlying_type& underlying, int amount) : underlying_(&underlying), amount_(amount) {}
-    pixel_type read(int x) const {
-        return underlying_->read(x);
+    pixel_type read(int x, int y) const {
+        return underlying_->read(x, y);
     }
     void write(int x, int y, pixel_type value) {
         pixel_type p = underlying_->read(x, y);
         underlying_->write(x, y, p+amount_);
     }
+    Range2d clip_range() const {
+      return ClipRange(*underlying_);
+    }
     int width() const {
       return underlying_->width();
     }
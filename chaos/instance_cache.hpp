@@ -0,0 +1,197 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_INSTANCE_CACHE_HPP__
+#define __CHAOS_INSTANCE_CACHE_HPP__
+
+#include "image.hpp"
+#include "range.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace chaos {
+
+// Self-similar renderers draw the same pattern, at the same pixel size, in
+// every subtree below some depth. An InstanceCache lets them draw each such
+// subtree once, recording the pixels it sets relative to an origin, and stamp
+// the recording into every other instance.
+
+// A run of pixels [x0, x1) on row y, relative to an instance's origin.
+struct InstanceRun {
+  int y;
+  int x0;
+  int x1;
+};
+
+// An InstanceRecording is the set of pixels a subtree draws, as runs sorted
+// by row and then column, with no two runs touching.
+using InstanceRecording = std::vector<InstanceRun>;
+
+// Identifies a subtree. Renderers fill in whatever determines the pixels a
+// subtree draws, typically its remaining depth, its size, and the position of
+// its origin within a pixel, quantized with InstanceKeyCoord.
+using InstanceKey = std::array<int64_t, 6>;
+
+// Quantizes a coordinate to 2^-24 of a pixel for use in an InstanceKey.
+// Subtrees whose coordinates differ by less than that differ only where their
+// own rounding would have decided a pixel anyway.
+inline int64_t InstanceKeyCoord(double value) {
+  return std::llround(std::ldexp(value, 24));
+}
+
+// Maps InstanceKeys to recordings. Lookups and insertions may come from any
+// thread; recordings are never moved or freed while the cache lives.
+class InstanceCache {
+  public:
+    // Returns the recording for key, or nullptr if there is none yet.
+    const InstanceRecording* Find(const InstanceKey& key) {
+      std::lock_guard lock(mutex_);
+      auto it = entries_.find(key);
+      if (it == entries_.end()) {
+        misses_++;
+        return nullptr;
+      }
+      hits_++;
+      return it->second.get();
+    }
+    // Returns whether recording another subtree is likely to pay off. A
+    // recording costs a few times as much as drawing the subtree directly,
+    // so past the first few, it is only worth it while most lookups hit.
+    // Renders whose subtrees seldom repeat then fall back to drawing.
+    bool WorthRecording() const {
+      std::lock_guard lock(mutex_);
+      return misses_ < kMinRecordings || hits_ >= 4*misses_;
+    }
+    // Stores recording under key, unless another thread got there first, and
+    // returns the stored recording.
+    const InstanceRecording& Insert(const InstanceKey& key, InstanceRecording recording) {
+      std::lock_guard lock(mutex_);
+      auto [it, inserted] = entries_.try_emplace(key);
+      if (inserted) {
+        it->second = std::make_unique<InstanceRecording>(std::move(recording));
+      }
+      return *it->second;
+    }
+
+  private:
+    static constexpr int64_t kMinRecordings = 8;
+    mutable std::mutex mutex_;
+    int64_t hits_ = 0;
+    int64_t misses_ = 0;
+    std::map<InstanceKey, std::unique_ptr<InstanceRecording>> entries_;
+};
+
+namespace internal {
+
+// Recorders accept writes anywhere up to this coordinate, so that subtrees
+// are recorded whole, whatever part of them the real destination keeps.
+constexpr int kRecorderExtent = 1 << 30;
+
+// Sorts runs and merges those that overlap or touch.
+inline void NormalizeRecording(InstanceRecording& runs) {
+  std::sort(runs.begin(), runs.end(), [](const InstanceRun& a, const InstanceRun& b) {
+    return a.y != b.y ? a.y < b.y : a.x0 < b.x0;
+  });
+  size_t out = 0;
+  for (const InstanceRun& run : runs) {
+    if (out > 0 && runs[out-1].y == run.y && run.x0 <= runs[out-1].x1) {
+      runs[out-1].x1 = std::max(runs[out-1].x1, run.x1);
+    } else {
+      runs[out++] = run;
+    }
+  }
+  runs.resize(out);
+}
+
+}  // namespace internal
+
+// A RecordingImage1d records the spans written to it, relative to origin, as
+// runs on row 0. The values written are ignored.
+class RecordingImage1d {
+  public:
+    using pixel_type = uint8_t;
+    RecordingImage1d(int origin, InstanceRecording& runs) : origin_(origin), runs_(&runs) {}
+    void write(int x, pixel_type value) {
+      write_span(x, x+1, value);
+    }
+    void write_span(int x0, int x1, pixel_type) {
+      runs_->push_back(InstanceRun{0, x0 - origin_, x1 - origin_});
+    }
+    int width() const {
+      return internal::kRecorderExtent;
+    }
+  private:
+    int origin_;
+    InstanceRecording* runs_;
+};
+
+// The 2-D counterpart of RecordingImage1d.
+class RecordingImage2d {
+  public:
+    using pixel_type = uint8_t;
+    RecordingImage2d(int origin_x, int origin_y, InstanceRecording& runs)
+        : origin_x_(origin_x), origin_y_(origin_y), runs_(&runs) {}
+    void write(int x, int y, pixel_type value) {
+      write_span(x, x+1, y, value);
+    }
+    void write_span(int x0, int x1, int y, pixel_type) {
+      runs_->push_back(InstanceRun{y - origin_y_, x0 - origin_x_, x1 - origin_x_});
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
+    int width() const {
+      return internal::kRecorderExtent;
+    }
+    int height() const {
+      return internal::kRecorderExtent;
+    }
+  private:
+    int origin_x_;
+    int origin_y_;
+    InstanceRecording* runs_;
+};
+
+// Sets the pixels of recording, placed at (x, y), that fall within clip, to
+// value. Each run is clipped and written with one WriteSpan, which reaches
+// the image's own write_span, so packed and contiguous images fill whole
+// words or bytes at a time; there is no separate row-wise memcpy or bit-blit
+// path, since recordings of fractal subtrees are mostly short runs.
+template <Image1dWritable ImageT>
+void StampInstance(ImageT& dest, const InstanceRecording& recording, int x, Range<int> clip, typename ImageT::pixel_type value) {
+  for (const InstanceRun& run : recording) {
+    int x0 = std::max(run.x0 + x, clip.x0);
+    int x1 = std::min(run.x1 + x, clip.x1);
+    if (x0 < x1) {
+      internal::WriteSpan(dest, x0, x1, value);
+    }
+  }
+}
+
+template <Image2dWritable ImageT>
+void StampInstance(ImageT& dest, const InstanceRecording& recording, int x, int y, Range2d clip, typename ImageT::pixel_type value) {
+  for (const InstanceRun& run : recording) {
+    int row = run.y + y;
+    if (row < clip.y0 || row >= clip.y1) {
+      continue;
+    }
+    int x0 = std::max(run.x0 + x, clip.x0);
+    int x1 = std::min(run.x1 + x, clip.x1);
+    if (x0 < x1) {
+      internal::WriteSpan(dest, x0, x1, row, value);
+    }
+  }
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_INSTANCE_CACHE_HPP__
@@ -4,10 +4,13 @@
 #define __CHAOS_LINE_HPP__
 
 #include "range.hpp"
+#include "fill.hpp"
 #include "image.hpp"
 #include "point.hpp"
+#include "stats.hpp"
 #include "utils.hpp"
 
+#include <cmath>
 #include <cstdint>
 #include <concepts>
 #include <vector>
@@ -15,8 +18,11 @@
 
 namespace chaos {
 
-// Represents a line segment.
-using Line1d = Range<double>;
+// Represents a line segment with endpoints of type CoordT.
+template <typename CoordT>
+using BasicLine1d = Range<CoordT>;
+
+using Line1d = BasicLine1d<double>;
 
 // Concept Line1dDrawable is satisfied by types that can have line segments
 // drawn on them.
@@ -34,11 +40,10 @@ class LineWriter1d {
     using pixel_type = typename underlying_type::pixel_type;
     LineWriter1d(underlying_type& underlying) : underlying_(&underlying) {}
     void DrawLine(Line1d line, pixel_type value) {
-      int x0 = std::max(0, int(line.x0+0.5));
-      int x1 = std::min(int(line.x1+0.5), width());
-      for (int x = x0; x < x1; x++) {
-        underlying_->write(x, value);
-      }
+      Fill(*underlying_, int(line.x0+0.5), int(line.x1+0.5), value);
+    }
+    Range<int> clip_range() const {
+      return ClipRange1d(*underlying_);
     }
     int width() const {
       return underlying_->width();
@@ -56,29 +61,40 @@ struct Arc {
   Polar p1;
 };
 
-// A LineWriterPolarArc can draw arcs in polar coordinates.
-template <Image2dWritable UnderlyingImageT>
+namespace internal {
+// NullRenderStats holds no state, so one instance serves every writer.
+inline NullRenderStats& SharedNullRenderStats() {
+  static NullRenderStats stats;
+  return stats;
+}
+}  // namespace internal
+
+// A LineWriterPolarArc can draw arcs in polar coordinates. Given a stats
+// collector, it reports its recursion and rejected writes there.
+template <Image2dWritable UnderlyingImageT, RenderStatsCollector StatsT = NullRenderStats>
 class LineWriterPolarArc {
   public:
     using underlying_type = UnderlyingImageT;
     using pixel_type = typename underlying_type::pixel_type;
-    LineWriterPolarArc(underlying_type& underlying, double inner_r, double outer_r) : underlying_(&underlying), inner_r_(inner_r), outer_r_(outer_r) {
+    LineWriterPolarArc(underlying_type& underlying, double inner_r, double outer_r) requires std::same_as<StatsT, NullRenderStats>
+        : LineWriterPolarArc(underlying, inner_r, outer_r, internal::SharedNullRenderStats()) {}
+    LineWriterPolarArc(underlying_type& underlying, double inner_r, double outer_r, StatsT& stats) : underlying_(&underlying), stats_(&stats), inner_r_(inner_r), outer_r_(outer_r) {
       // Width is reported as the size of the circle that encompasses the
       // full underlying image. This way maximum resolution is achieved, even
       // at the edges of the image. 
       double d = sqrt(underlying_->width()*underlying_->width() + underlying_->height()*underlying_->height());
-      // std::cout << "d " << d << std::endl;
       width_ = int(M_PI*d);
-      // std::cout << "width " << width_ << std::endl;
     }
 
-    // TODO: handle wrapping
-    void DrawArcRecursive(Arc arc, pixel_type value) {
-      // std::cout << "Drawing arc " << arc.p0.r << " " << arc.p0.theta << " " << arc.p1.r << " " << arc.p1.theta << std::endl;
+    // Arcs are not wrapped past 2*pi. To draw a whole line around a ring,
+    // wrapping included, render it to an Image1d and use WarpPolar.
+    void DrawArcRecursive(Arc arc, pixel_type value, int depth = 0) {
+      stats_->Visit(depth);
       Point2 p0 = Cartesian(arc.p0);
       Point2 p1 = Cartesian(arc.p1);
       if (Dist(p0, p1) < 1.0) {
-        SafeWrite(*underlying_, int(p0.x), int(p0.y), value);
+        stats_->Cutoff(depth);
+        SafeWrite(*underlying_, int(p0.x), int(p0.y), value, *stats_);
         return;
       }
       double avg_r = (arc.p0.r + arc.p1.r)/2;
@@ -86,19 +102,19 @@ class LineWriterPolarArc {
       DrawArcRecursive(Arc{
         Polar{arc.p0.r, arc.p0.theta},
         Polar{avg_r, avg_theta}
-      }, value);
+      }, value, depth+1);
       DrawArcRecursive(Arc{
         Polar{arc.p0.r, avg_theta},
         Polar{avg_r, arc.p1.theta}
-      }, value);
+      }, value, depth+1);
       DrawArcRecursive(Arc{
         Polar{avg_r, arc.p0.theta},
         Polar{arc.p1.r, avg_theta}
-      }, value);
+      }, value, depth+1);
       DrawArcRecursive(Arc{
         Polar{avg_r, avg_theta},
         Polar{arc.p1.r, arc.p1.theta}
-      }, value);
+      }, value, depth+1);
     }
 
     void DrawLine(Line1d line, pixel_type value) {
@@ -124,6 +140,7 @@ class LineWriterPolarArc {
       };
     }
     underlying_type* underlying_;
+    StatsT* stats_;
     int width_;
     double inner_r_;
     double outer_r_;
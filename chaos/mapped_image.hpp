@@ -0,0 +1,324 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_MAPPED_IMAGE_HPP__
+#define __CHAOS_MAPPED_IMAGE_HPP__
+
+#include "image.hpp"
+#include "pgm.hpp"
+#include "range.hpp"
+#include "status.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace chaos {
+
+namespace internal {
+
+inline Status ErrnoStatus(const std::string& what) {
+  return Status{errno, what + ": " + std::strerror(errno)};
+}
+
+// A MappedFile is a file mapped read-write into memory. Changes to the mapping
+// are written back to the file by the kernel.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    ~MappedFile() {
+      Close();
+    }
+    MappedFile(MappedFile&& other) : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+    MappedFile& operator=(MappedFile&& other) {
+      if (this != &other) {
+        Close();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+      }
+      return *this;
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Creates or truncates filename to size bytes, all zero, and maps it.
+    Status Create(const std::string& filename, size_t size) {
+      return Map(filename, O_RDWR | O_CREAT | O_TRUNC, size);
+    }
+    // Maps the existing file filename.
+    Status Open(const std::string& filename) {
+      return Map(filename, O_RDWR, 0);
+    }
+    // Writes back and unmaps the file.
+    Status Close() {
+      Status status{0, ""};
+      if (data_ != nullptr) {
+        if (msync(data_, size_, MS_SYNC) != 0) {
+          status = ErrnoStatus("msync");
+        }
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+      }
+      return status;
+    }
+
+    uint8_t* data() const {
+      return data_;
+    }
+    size_t size() const {
+      return size_;
+    }
+
+  private:
+    Status Map(const std::string& filename, int flags, size_t size) {
+      Close();
+      int fd = open(filename.c_str(), flags, 0644);
+      if (fd < 0) {
+        return ErrnoStatus("open " + filename);
+      }
+      if (flags & O_CREAT) {
+        if (ftruncate(fd, size) != 0) {
+          Status status = ErrnoStatus("ftruncate " + filename);
+          close(fd);
+          return status;
+        }
+      } else {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+          Status status = ErrnoStatus("fstat " + filename);
+          close(fd);
+          return status;
+        }
+        size = info.st_size;
+      }
+      void* data = (size == 0) ? nullptr : mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      Status status{0, ""};
+      if (data == MAP_FAILED) {
+        status = ErrnoStatus("mmap " + filename);
+        data = nullptr;
+        size = 0;
+      }
+      close(fd);
+      data_ = static_cast<uint8_t*>(data);
+      size_ = size;
+      return status;
+    }
+
+    uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Maps filename and checks that it holds a binary PNM with the given magic
+// and maxval, filling in width, height and the pixel offset.
+inline Status OpenMappedPnm(MappedFile& file, const std::string& filename, const char* magic, int maxval, PnmHeaderInfo& info) {
+  Status status = file.Open(filename);
+  if (!status.ok()) {
+    return status;
+  }
+  if (!ParsePnmHeader(file.data(), file.size(), info) || info.magic != magic || info.maxval != maxval) {
+    file.Close();
+    return Status{EINVAL, filename + ": not a " + magic + " image with maxval " + std::to_string(maxval)};
+  }
+  size_t row_bytes = (info.magic == "P4") ? PbmRowBytes(info.width) : size_t(info.width);
+  if (file.size() < info.data_offset + row_bytes*info.height) {
+    file.Close();
+    return Status{EINVAL, filename + ": file is shorter than its header says"};
+  }
+  return Status{0, ""};
+}
+
+}  // namespace internal
+
+// A MappedImage2d stores its pixels in a memory-mapped binary (P5) PGM file,
+// so rendering writes the output file in place and nothing needs to be
+// serialized afterwards. Pixels must be one byte. Create() or Open() must
+// succeed before the image is used; the file is complete once Close() is
+// called or the image is destroyed.
+template <typename PixelT>
+class MappedImage2d {
+  static_assert(sizeof(PixelT) == 1, "MappedImage2d pixels are single bytes");
+  public:
+    using pixel_type = PixelT;
+
+    // Creates filename as a width x height image with every pixel zero.
+    Status Create(const std::string& filename, int width, int height) {
+      std::string header = internal::PnmHeader("P5", width, height, 255);
+      Status status = file_.Create(filename, header.size() + size_t(width)*height);
+      if (!status.ok()) {
+        return status;
+      }
+      std::memcpy(file_.data(), header.data(), header.size());
+      SetLayout(width, height, header.size());
+      return status;
+    }
+    // Opens an existing 8-bit P5 file so that it can be drawn over.
+    Status Open(const std::string& filename) {
+      internal::PnmHeaderInfo info;
+      Status status = internal::OpenMappedPnm(file_, filename, "P5", 255, info);
+      if (status.ok()) {
+        SetLayout(info.width, info.height, info.data_offset);
+      }
+      return status;
+    }
+    Status Close() {
+      Status status = file_.Close();
+      SetLayout(0, 0, 0);
+      return status;
+    }
+
+    void write(int x, int y, pixel_type value) {
+      row(y)[x] = value;
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      std::fill(row(y) + x0, row(y) + x1, value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
+    pixel_type read(int x, int y) const {
+      return row(y)[x];
+    }
+    pixel_type* row(int y) {
+      return pixels_ + size_t(y)*width_;
+    }
+    const pixel_type* row(int y) const {
+      return pixels_ + size_t(y)*width_;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    void SetLayout(int width, int height, size_t data_offset) {
+      width_ = width;
+      height_ = height;
+      pixels_ = (file_.data() == nullptr) ? nullptr : reinterpret_cast<pixel_type*>(file_.data() + data_offset);
+    }
+    internal::MappedFile file_;
+    pixel_type* pixels_ = nullptr;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+// A MappedBitImage2d is a bilevel image stored in a memory-mapped bit-packed
+// (P4) PBM file. As with WritePbm, true pixels appear white, so they are
+// stored as 0 bits.
+class MappedBitImage2d {
+  public:
+    using pixel_type = bool;
+
+    // Creates filename as a width x height image with every pixel false.
+    Status Create(const std::string& filename, int width, int height) {
+      std::string header = internal::PnmHeader("P4", width, height, 0);
+      size_t stride = internal::PbmRowBytes(width);
+      Status status = file_.Create(filename, header.size() + stride*height);
+      if (!status.ok()) {
+        return status;
+      }
+      std::memcpy(file_.data(), header.data(), header.size());
+      SetLayout(width, height, header.size());
+      // False pixels are black, which PBM stores as 1. Padding bits at the end
+      // of each row are left 0, as WritePbm writes them.
+      std::memset(pixels_, 0xff, stride*height);
+      if (width % 8 != 0) {
+        for (int y = 0; y < height; y++) {
+          row_bytes(y)[stride - 1] = uint8_t(0xff << (8 - width % 8));
+        }
+      }
+      return status;
+    }
+    // Opens an existing P4 file so that it can be drawn over.
+    Status Open(const std::string& filename) {
+      internal::PnmHeaderInfo info;
+      Status status = internal::OpenMappedPnm(file_, filename, "P4", 1, info);
+      if (status.ok()) {
+        SetLayout(info.width, info.height, info.data_offset);
+      }
+      return status;
+    }
+    Status Close() {
+      Status status = file_.Close();
+      SetLayout(0, 0, 0);
+      return status;
+    }
+
+    void write(int x, int y, pixel_type value) {
+      uint8_t& byte = row_bytes(y)[x/8];
+      uint8_t mask = uint8_t(0x80 >> (x % 8));
+      if (value) {
+        byte &= uint8_t(~mask);
+      } else {
+        byte |= mask;
+      }
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      if (x0 >= x1) {
+        return;
+      }
+      uint8_t* row = row_bytes(y);
+      int b0 = x0/8;
+      int b1 = (x1 - 1)/8;
+      if (b0 == b1) {
+        WriteMasked(row[b0], SpanMask(x0 % 8, (x1 - 1) % 8 + 1), value);
+        return;
+      }
+      WriteMasked(row[b0], SpanMask(x0 % 8, 8), value);
+      std::memset(row + b0 + 1, value ? 0x00 : 0xff, b1 - b0 - 1);
+      WriteMasked(row[b1], SpanMask(0, (x1 - 1) % 8 + 1), value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        write_span(range.x0, range.x1, y, value);
+      }
+    }
+    pixel_type read(int x, int y) const {
+      return !((row_bytes(y)[x/8] << (x % 8)) & 0x80);
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    uint8_t* row_bytes(int y) const {
+      return pixels_ + size_t(y)*stride_;
+    }
+    // Returns the bits for pixels [lo, hi) of a byte, 0 <= lo < hi <= 8.
+    static uint8_t SpanMask(int lo, int hi) {
+      return uint8_t((0xff >> lo) & (0xff << (8 - hi)));
+    }
+    static void WriteMasked(uint8_t& byte, uint8_t mask, pixel_type value) {
+      if (value) {
+        byte &= uint8_t(~mask);
+      } else {
+        byte |= mask;
+      }
+    }
+    void SetLayout(int width, int height, size_t data_offset) {
+      width_ = width;
+      height_ = height;
+      stride_ = internal::PbmRowBytes(width);
+      pixels_ = (file_.data() == nullptr) ? nullptr : file_.data() + data_offset;
+    }
+    internal::MappedFile file_;
+    uint8_t* pixels_ = nullptr;
+    size_t stride_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_MAPPED_IMAGE_HPP__
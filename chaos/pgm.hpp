@@ -3,40 +3,334 @@
 #ifndef __CHAOS_PGM_HPP__
 #define __CHAOS_PGM_HPP__
 
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
 #include <fstream>
+#include <string>
+#include <vector>
 
 #include "image.hpp"
+#include "status.hpp"
 
 namespace chaos {
 
+namespace internal {
+
+// Encoded rows are collected into a buffer of roughly this many bytes before
+// being handed to the stream.
+constexpr size_t kPnmWriteBufferSize = 1 << 20;
+
+inline std::string PnmHeader(const char* magic, int width, int height, int maxval) {
+  std::string header = std::string(magic) + "\n" + std::to_string(width) + " " + std::to_string(height) + "\n";
+  if (maxval > 0) {
+    header += std::to_string(maxval) + "\n";
+  }
+  return header;
+}
+
+// The fields of a binary PNM header.
+struct PnmHeaderInfo {
+  std::string magic;
+  int width = 0;
+  int height = 0;
+  // 1 for P4, which has no maxval field.
+  int maxval = 1;
+  // Offset of the first pixel byte.
+  size_t data_offset = 0;
+};
+
+// Parses the header of the P4 or P5 image in data[0, size). Returns false if
+// it is not one.
+inline bool ParsePnmHeader(const uint8_t* data, size_t size, PnmHeaderInfo& info) {
+  size_t pos = 0;
+  auto skip_space = [&] {
+    while (pos < size && (std::isspace(data[pos]) || data[pos] == '#')) {
+      if (data[pos] == '#') {
+        while (pos < size && data[pos] != '\n') {
+          pos++;
+        }
+      } else {
+        pos++;
+      }
+    }
+  };
+  auto read_int = [&](int& value) {
+    skip_space();
+    auto result = std::from_chars(reinterpret_cast<const char*>(data) + pos, reinterpret_cast<const char*>(data) + size, value);
+    if (result.ec != std::errc()) {
+      return false;
+    }
+    pos = reinterpret_cast<const uint8_t*>(result.ptr) - data;
+    return true;
+  };
+  if (size < 2 || data[0] != 'P' || (data[1] != '4' && data[1] != '5')) {
+    return false;
+  }
+  info.magic = std::string(reinterpret_cast<const char*>(data), 2);
+  pos = 2;
+  if (!read_int(info.width) || !read_int(info.height)) {
+    return false;
+  }
+  info.maxval = 1;
+  if (info.magic == "P5" && !read_int(info.maxval)) {
+    return false;
+  }
+  // Exactly one whitespace character separates the header from the pixels.
+  if (pos >= size || !std::isspace(data[pos])) {
+    return false;
+  }
+  info.data_offset = pos + 1;
+  return true;
+}
+
+// Number of bytes in one row of a P4 (bit-packed PBM) image.
+inline size_t PbmRowBytes(int width) {
+  return (size_t(width) + 7) / 8;
+}
+
+// Appends row y of image to out as ASCII samples, each followed by a space.
 template <Image2dReadable ImageT>
-void WriteBlackWhitePgm(const ImageT& image, const std::string& filename) {
-  std::ofstream outfile;
-  outfile.open(filename);
-  outfile << "P2" << std::endl;
-  outfile << int(image.width()) << " " << int(image.height()) << std::endl;
-  outfile << "1" << std::endl;
-  for (int y = 0; y < image.height(); y++) {
+void AppendAsciiPgmRow(const ImageT& image, int y, std::string& out) {
+  char digits[16];
+  for (int x = 0; x < image.width(); x++) {
+    auto result = std::to_chars(digits, digits + sizeof(digits), (int)image.read(x, y));
+    out.append(digits, result.ptr);
+    out.push_back(' ');
+  }
+  out.push_back('\n');
+}
+
+// Sets bits [x0, x1) of a row packed most significant bit first, as P4 and
+// PNG pack them, to bit.
+inline void SetPackedBits(uint8_t* row, int x0, int x1, bool bit) {
+  auto set = [bit](uint8_t& byte, uint8_t mask) {
+    byte = bit ? (byte | mask) : (byte & ~mask);
+  };
+  int b0 = x0/8;
+  int b1 = (x1 - 1)/8;
+  uint8_t head = uint8_t(0xff >> (x0 % 8));
+  uint8_t tail = uint8_t(0xff << (7 - (x1 - 1) % 8));
+  if (b0 == b1) {
+    set(row[b0], head & tail);
+    return;
+  }
+  set(row[b0], head);
+  std::fill(row + b0 + 1, row + b1, bit ? 0xff : 0x00);
+  set(row[b1], tail);
+}
+
+// Encodes row y of image as 8-bit P5 samples into out, which must hold
+// image.width() bytes.
+template <Image2dReadable ImageT>
+void EncodePgmRow(const ImageT& image, int y, uint8_t* out) {
+  if constexpr (Image2dContiguous<ImageT>) {
+    const auto* row = image.row(y);
+    for (int x = 0; x < image.width(); x++) {
+      out[x] = uint8_t(row[x]);
+    }
+  } else if constexpr (Image2dRunLength<ImageT>) {
+    std::fill(out, out + image.width(), uint8_t(typename ImageT::pixel_type{}));
+    for (const auto& run : image.row_runs(y)) {
+      std::fill(out + run.x0, out + run.x1, uint8_t(run.value));
+    }
+  } else {
     for (int x = 0; x < image.width(); x++) {
-      outfile << (int)image.read(x, y) << " ";
+      out[x] = uint8_t(image.read(x, y));
     }
-      outfile << std::endl;
   }
 }
 
+// Maps a byte to the same byte with its bit order reversed.
+constexpr std::array<uint8_t, 256> kReversedBits = [] {
+  std::array<uint8_t, 256> table{};
+  for (int i = 0; i < 256; i++) {
+    for (int bit = 0; bit < 8; bit++) {
+      if (i & (1 << bit)) {
+        table[i] |= uint8_t(0x80 >> bit);
+      }
+    }
+  }
+  return table;
+}();
+
+// Encodes row y of image as P4 bits into out, which must hold
+// PbmRowBytes(image.width()) bytes. PBM uses 1 for black, so nonzero pixels
+// are written as 0 to match the appearance of WriteBlackWhitePgm.
 template <Image2dReadable ImageT>
-void WritePgm(const ImageT& image, const std::string& filename) {
+void EncodePbmRow(const ImageT& image, int y, uint8_t* out) {
+  int width = image.width();
+  if constexpr (Image2dBitPacked<ImageT>) {
+    // Bit-packed rows hold pixel x in bit (x % 8) of byte (x / 8), so each
+    // byte only needs its bits reversed and inverted.
+    const uint64_t* words = image.row_words(y);
+    size_t num_bytes = PbmRowBytes(width);
+    for (size_t i = 0; i < num_bytes; i++) {
+      out[i] = uint8_t(~kReversedBits[uint8_t(words[i/8] >> (8*(i%8)))]);
+    }
+    if (width % 8 != 0) {
+      out[num_bytes - 1] &= uint8_t(0xff << (8 - width % 8));
+    }
+    return;
+  }
+  if constexpr (Image2dRunLength<ImageT>) {
+    // Pixels outside the runs are zero, which is black.
+    size_t num_bytes = PbmRowBytes(width);
+    std::fill(out, out + num_bytes, 0xff);
+    for (const auto& run : image.row_runs(y)) {
+      if (run.value) {
+        SetPackedBits(out, run.x0, run.x1, false);
+      }
+    }
+    if (width % 8 != 0) {
+      out[num_bytes - 1] &= uint8_t(0xff << (8 - width % 8));
+    }
+    return;
+  }
+  for (int x0 = 0; x0 < width; x0 += 8) {
+    uint8_t byte = 0;
+    int n = std::min(8, width - x0);
+    for (int i = 0; i < n; i++) {
+      if (!image.read(x0 + i, y)) {
+        byte |= uint8_t(0x80 >> i);
+      }
+    }
+    out[x0/8] = byte;
+  }
+}
+
+// Writes rows [0, height) using encode(y, buffer) to produce row_bytes bytes
+// per row, batching many rows into each write.
+template <typename EncodeFn>
+void WriteEncodedRows(std::ofstream& outfile, int height, size_t row_bytes, EncodeFn encode) {
+  if (row_bytes == 0) {
+    return;
+  }
+  size_t rows_per_block = std::max<size_t>(1, kPnmWriteBufferSize / row_bytes);
+  std::vector<uint8_t> buffer(rows_per_block * row_bytes);
+  for (int y0 = 0; y0 < height; y0 += rows_per_block) {
+    int y1 = std::min<int>(height, y0 + rows_per_block);
+    for (int y = y0; y < y1; y++) {
+      encode(y, buffer.data() + size_t(y - y0)*row_bytes);
+    }
+    outfile.write(reinterpret_cast<const char*>(buffer.data()), size_t(y1 - y0)*row_bytes);
+  }
+}
+
+template <Image2dReadable ImageT>
+void WriteAsciiPgm(const ImageT& image, const std::string& filename, int maxval) {
   std::ofstream outfile;
   outfile.open(filename);
-  outfile << "P2" << std::endl;
-  outfile << int(image.width()) << " " << int(image.height()) << std::endl;
-  outfile << "255" << std::endl;
+  outfile << PnmHeader("P2", image.width(), image.height(), maxval);
+  std::string buffer;
+  buffer.reserve(kPnmWriteBufferSize);
   for (int y = 0; y < image.height(); y++) {
-    for (int x = 0; x < image.width(); x++) {
-      outfile << (int)image.read(x, y) << " ";
+    AppendAsciiPgmRow(image, y, buffer);
+    if (buffer.size() >= kPnmWriteBufferSize) {
+      outfile.write(buffer.data(), buffer.size());
+      buffer.clear();
     }
-      outfile << std::endl;
   }
+  outfile.write(buffer.data(), buffer.size());
+}
+
+}  // namespace internal
+
+template <Image2dReadable ImageT>
+void WriteBlackWhitePgm(const ImageT& image, const std::string& filename) {
+  internal::WriteAsciiPgm(image, filename, 1);
+}
+
+template <Image2dReadable ImageT>
+void WritePgm(const ImageT& image, const std::string& filename) {
+  internal::WriteAsciiPgm(image, filename, 255);
+}
+
+// The binary formats produced by PnmStreamWriter.
+enum class PnmFormat {
+  kPgm,  // P5, one byte per pixel.
+  kPbm,  // P4, one bit per pixel; nonzero pixels appear white.
+};
+
+// A PnmStreamWriter writes a binary PGM or PBM a block of rows at a time, so
+// the whole image never needs to be in memory at once.
+class PnmStreamWriter {
+  public:
+    PnmStreamWriter(const std::string& filename, PnmFormat format, int width, int height)
+        : filename_(filename), format_(format), width_(width), height_(height) {
+      outfile_.open(filename, std::ios::binary);
+      if (format_ == PnmFormat::kPgm) {
+        outfile_ << internal::PnmHeader("P5", width, height, 255);
+      } else {
+        outfile_ << internal::PnmHeader("P4", width, height, 0);
+      }
+    }
+
+    // Appends rows [0, num_rows) of image, which must be width() wide, as the
+    // next rows of the file. Images with 8-bit contiguous storage are written
+    // straight from memory.
+    template <Image2dReadable ImageT>
+    void WriteRows(const ImageT& image, int num_rows) {
+      if (format_ == PnmFormat::kPbm) {
+        internal::WriteEncodedRows(outfile_, num_rows, internal::PbmRowBytes(width_), [&](int y, uint8_t* out) {
+          internal::EncodePbmRow(image, y, out);
+        });
+      } else if constexpr (Image2dContiguous<ImageT> && sizeof(typename ImageT::pixel_type) == 1) {
+        for (int y = 0; y < num_rows; y++) {
+          outfile_.write(reinterpret_cast<const char*>(image.row(y)), width_);
+        }
+      } else {
+        internal::WriteEncodedRows(outfile_, num_rows, width_, [&](int y, uint8_t* out) {
+          internal::EncodePgmRow(image, y, out);
+        });
+      }
+      rows_written_ += num_rows;
+    }
+
+    // Flushes and closes the file, reporting whether every write succeeded.
+    // The destructor closes the file too, but cannot report errors.
+    Status Close() {
+      outfile_.close();
+      if (!outfile_) {
+        return Status{EIO, "error writing " + filename_};
+      }
+      return Status{0, ""};
+    }
+
+    int rows_written() const {
+      return rows_written_;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+  private:
+    std::string filename_;
+    std::ofstream outfile_;
+    PnmFormat format_;
+    int width_;
+    int height_;
+    int rows_written_ = 0;
+};
+
+// Writes image as a binary (P5) PGM with one byte per pixel.
+template <Image2dReadable ImageT>
+void WriteBinaryPgm(const ImageT& image, const std::string& filename) {
+  PnmStreamWriter writer(filename, PnmFormat::kPgm, image.width(), image.height());
+  writer.WriteRows(image, image.height());
+}
+
+// Writes image as a bit-packed (P4) PBM. Nonzero pixels appear white, as with
+// WriteBlackWhitePgm.
+template <Image2dReadable ImageT>
+void WritePbm(const ImageT& image, const std::string& filename) {
+  PnmStreamWriter writer(filename, PnmFormat::kPbm, image.width(), image.height());
+  writer.WriteRows(image, image.height());
 }
 
 } // namespace chaos
@@ -0,0 +1,359 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_PNG_HPP__
+#define __CHAOS_PNG_HPP__
+
+#include "image.hpp"
+#include "pgm.hpp"
+#include "status.hpp"
+#include "thread_pool.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace chaos {
+
+// PNG output needs zlib; the CMake build links it when it is found.
+
+enum class PngFormat {
+  kGray8,  // 8-bit grayscale, pixels cast to uint8_t as by WriteBinaryPgm.
+  kGray1,  // 1-bit grayscale; nonzero pixels appear white, as with WritePbm.
+};
+
+// The filter applied to every row before deflating it.
+enum class PngFilter {
+  // Rows are deflated as they are, so 8-bit rows of contiguous images are
+  // read straight from the image.
+  kNone,
+  // Each byte minus the one above it, which turns repeated rows into zeros.
+  kUp,
+};
+
+struct PngOptions {
+  PngFormat format = PngFormat::kGray8;
+  PngFilter filter = PngFilter::kNone;
+  // zlib compression level, 0 to 9.
+  int level = 6;
+  // Number of threads to deflate with; 0 uses every hardware thread.
+  int threads = 1;
+};
+
+namespace internal {
+
+// Rows are deflated in bands of roughly this many bytes, one band per task.
+constexpr size_t kPngBandBytes = size_t(1) << 20;
+// The deflate window. Each band is primed with this much of the data before
+// it, so splitting the image costs almost nothing in compression.
+constexpr size_t kDeflateWindow = 32768;
+
+inline size_t PngRowBytes(int width, PngFormat format) {
+  return format == PngFormat::kGray1 ? PbmRowBytes(width) : size_t(width);
+}
+
+// Produces the unfiltered bytes of rows of an image.
+template <Image2dReadable ImageT>
+class PngRowReader {
+  public:
+    PngRowReader(const ImageT& image, PngFormat format)
+        : image_(image), format_(format), scratch_(PngRowBytes(image.width(), format)) {}
+
+    // Returns the bytes of row y, which stay valid until the next call.
+    const uint8_t* Read(int y) {
+      int width = image_.width();
+      uint8_t* out = scratch_.data();
+      if (format_ == PngFormat::kGray8) {
+        if constexpr (Image2dContiguous<ImageT> && std::is_same_v<std::remove_cv_t<typename ImageT::pixel_type>, uint8_t>) {
+          return image_.row(y);
+        } else {
+          EncodePgmRow(image_, y, out);
+          return out;
+        }
+      }
+      if constexpr (Image2dBitPacked<ImageT>) {
+        // Bit-packed rows hold pixel x in bit (x % 8) of byte (x / 8), and
+        // PNG wants it in bit 7 - x % 8.
+        const uint64_t* words = image_.row_words(y);
+        for (size_t i = 0; i < scratch_.size(); i++) {
+          out[i] = kReversedBits[uint8_t(words[i/8] >> (8*(i%8)))];
+        }
+      } else if constexpr (Image2dRunLength<ImageT>) {
+        std::fill(scratch_.begin(), scratch_.end(), 0);
+        for (const auto& run : image_.row_runs(y)) {
+          if (run.value) {
+            SetPackedBits(out, run.x0, run.x1, true);
+          }
+        }
+      } else {
+        for (int x0 = 0; x0 < width; x0 += 8) {
+          uint8_t byte = 0;
+          int n = std::min(8, width - x0);
+          for (int i = 0; i < n; i++) {
+            if (image_.read(x0 + i, y)) {
+              byte |= uint8_t(0x80 >> i);
+            }
+          }
+          out[x0/8] = byte;
+        }
+      }
+      if (width % 8 != 0) {
+        out[scratch_.size() - 1] &= uint8_t(0xff << (8 - width % 8));
+      }
+      return out;
+    }
+
+  private:
+    const ImageT& image_;
+    PngFormat format_;
+    std::vector<uint8_t> scratch_;
+};
+
+// Produces the filtered rows of an image as PNG stores them: a filter type
+// byte followed by the filtered row.
+template <Image2dReadable ImageT>
+class PngFilteredRows {
+  public:
+    PngFilteredRows(const ImageT& image, const PngOptions& options)
+        : reader_(image, options.format), filter_(options.filter), row_bytes_(PngRowBytes(image.width(), options.format)) {
+      if (filter_ == PngFilter::kUp) {
+        previous_.resize(row_bytes_);
+        filtered_.resize(row_bytes_);
+      }
+    }
+
+    size_t row_bytes() const {
+      return row_bytes_;
+    }
+
+    // Calls emit(data, size) once or twice with the filter byte and bytes of
+    // row y. Rows must be visited in increasing order; for kUp, the row
+    // before a band's first row must be visited first, if there is one.
+    template <typename EmitFn>
+    void Row(int y, bool has_previous, EmitFn emit) {
+      const uint8_t* row = reader_.Read(y);
+      if (filter_ == PngFilter::kNone) {
+        static constexpr uint8_t kNoneType = 0;
+        emit(&kNoneType, 1);
+        emit(row, row_bytes_);
+        return;
+      }
+      static constexpr uint8_t kUpType = 2;
+      for (size_t i = 0; i < row_bytes_; i++) {
+        filtered_[i] = uint8_t(row[i] - (has_previous ? previous_[i] : 0));
+      }
+      std::memcpy(previous_.data(), row, row_bytes_);
+      emit(&kUpType, 1);
+      emit(filtered_.data(), row_bytes_);
+    }
+
+  private:
+    PngRowReader<ImageT> reader_;
+    PngFilter filter_;
+    size_t row_bytes_;
+    std::vector<uint8_t> previous_;
+    std::vector<uint8_t> filtered_;
+};
+
+// A band of rows, deflated on its own as a piece of one zlib stream.
+struct PngBand {
+  int y0 = 0;
+  int y1 = 0;
+  std::vector<uint8_t> deflated;
+  // The Adler-32 of the band's uncompressed bytes, and their number.
+  uint32_t adler = 0;
+  size_t raw_size = 0;
+  bool ok = true;
+};
+
+// Deflates data into out with the given flush mode, growing out as needed.
+inline bool DeflateInto(z_stream& stream, const uint8_t* data, size_t size, int flush, std::vector<uint8_t>& out) {
+  stream.next_in = const_cast<Bytef*>(data);
+  stream.avail_in = uInt(size);
+  while (true) {
+    if (out.size() - stream.total_out < 64) {
+      out.resize(std::max<size_t>(4096, 2*out.size()));
+    }
+    stream.next_out = out.data() + stream.total_out;
+    stream.avail_out = uInt(out.size() - stream.total_out);
+    int result = deflate(&stream, flush);
+    if (result == Z_STREAM_ERROR) {
+      return false;
+    }
+    if (stream.avail_in == 0 && stream.avail_out != 0 && (flush != Z_FINISH || result == Z_STREAM_END)) {
+      return true;
+    }
+  }
+}
+
+// Deflates band.y0 to band.y1 as raw deflate data that can be joined to the
+// bands around it, as pigz does. Every band but the last ends with a sync
+// flush, which ends it on a byte boundary without ending the stream, and each
+// band after the first starts from the last kDeflateWindow bytes before it
+// as its dictionary, so matches can reach back across the join.
+template <Image2dReadable ImageT>
+void DeflatePngBand(const ImageT& image, const PngOptions& options, bool last, PngBand& band) {
+  PngFilteredRows<ImageT> rows(image, options);
+  size_t line_bytes = rows.row_bytes() + 1;
+  z_stream stream{};
+  if (deflateInit2(&stream, options.level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    band.ok = false;
+    return;
+  }
+  int dictionary_rows = int(std::min<size_t>(band.y0, (kDeflateWindow + line_bytes - 1)/line_bytes));
+  int first = band.y0 - dictionary_rows;
+  if (options.filter == PngFilter::kUp && first > 0) {
+    // Reads the row before the dictionary so that its first row filters the
+    // same way it did in the band before.
+    first--;
+  }
+  std::vector<uint8_t> dictionary;
+  for (int y = first; y < band.y0; y++) {
+    rows.Row(y, y > 0, [&](const uint8_t* data, size_t size) {
+      if (y >= band.y0 - dictionary_rows) {
+        dictionary.insert(dictionary.end(), data, data + size);
+      }
+    });
+  }
+  if (dictionary.size() > kDeflateWindow) {
+    dictionary.erase(dictionary.begin(), dictionary.end() - kDeflateWindow);
+  }
+  if (!dictionary.empty()) {
+    deflateSetDictionary(&stream, dictionary.data(), uInt(dictionary.size()));
+  }
+  band.adler = adler32(0, nullptr, 0);
+  band.raw_size = 0;
+  band.deflated.clear();
+  for (int y = band.y0; y < band.y1 && band.ok; y++) {
+    rows.Row(y, y > 0, [&](const uint8_t* data, size_t size) {
+      band.adler = adler32(band.adler, data, uInt(size));
+      band.raw_size += size;
+      band.ok = band.ok && DeflateInto(stream, data, size, Z_NO_FLUSH, band.deflated);
+    });
+  }
+  band.ok = band.ok && DeflateInto(stream, nullptr, 0, last ? Z_FINISH : Z_SYNC_FLUSH, band.deflated);
+  band.deflated.resize(stream.total_out);
+  deflateEnd(&stream);
+}
+
+inline void AppendBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out.push_back(uint8_t(value >> shift));
+  }
+}
+
+// Writes a chunk whose data is prefix followed by data.
+inline void WritePngChunk(std::ofstream& outfile, const char* type, const std::vector<uint8_t>& prefix,
+                          const uint8_t* data, size_t size, const std::vector<uint8_t>& suffix) {
+  std::vector<uint8_t> header;
+  AppendBigEndian32(header, uint32_t(prefix.size() + size + suffix.size()));
+  header.insert(header.end(), type, type + 4);
+  uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+  // crc32 treats a null buffer as a request for its initial value.
+  auto update = [&crc](const uint8_t* bytes, size_t n) {
+    if (n > 0) {
+      crc = crc32(crc, bytes, uInt(n));
+    }
+  };
+  update(prefix.data(), prefix.size());
+  update(data, size);
+  update(suffix.data(), suffix.size());
+  std::vector<uint8_t> trailer;
+  AppendBigEndian32(trailer, uint32_t(crc));
+  outfile.write(reinterpret_cast<const char*>(header.data()), header.size());
+  outfile.write(reinterpret_cast<const char*>(prefix.data()), prefix.size());
+  outfile.write(reinterpret_cast<const char*>(data), size);
+  outfile.write(reinterpret_cast<const char*>(suffix.data()), suffix.size());
+  outfile.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+}
+
+}  // namespace internal
+
+// Writes image as a grayscale PNG. The rows are split into bands that are
+// deflated in parallel when options.threads != 1, and written as they finish,
+// a few bands per thread at a time, so the encoded image is never all in
+// memory at once.
+template <Image2dReadable ImageT>
+Status WritePng(const ImageT& image, const std::string& filename, const PngOptions& options = PngOptions{}) {
+  int width = image.width();
+  int height = image.height();
+  if (width <= 0 || height <= 0) {
+    return Status{EINVAL, "PNG images cannot be empty"};
+  }
+  std::ofstream outfile(filename, std::ios::binary);
+  static constexpr uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  outfile.write(reinterpret_cast<const char*>(kSignature), sizeof(kSignature));
+  std::vector<uint8_t> ihdr;
+  internal::AppendBigEndian32(ihdr, width);
+  internal::AppendBigEndian32(ihdr, height);
+  // Bit depth, color type 0 (grayscale), compression, filter and interlace
+  // methods 0.
+  ihdr.insert(ihdr.end(), {uint8_t(options.format == PngFormat::kGray1 ? 1 : 8), 0, 0, 0, 0});
+  internal::WritePngChunk(outfile, "IHDR", {}, ihdr.data(), ihdr.size(), {});
+
+  // The zlib header, with the level recorded in FLG and FCHECK making the
+  // pair a multiple of 31.
+  int flevel = options.level < 2 ? 0 : options.level < 6 ? 1 : options.level == 6 ? 2 : 3;
+  int flg = flevel << 6;
+  flg += 31 - (0x78*256 + flg) % 31;
+  std::vector<uint8_t> zlib_header = {0x78, uint8_t(flg)};
+
+  size_t line_bytes = internal::PngRowBytes(width, options.format) + 1;
+  int band_rows = int(std::max<size_t>(1, internal::kPngBandBytes/line_bytes));
+  int num_bands = (height + band_rows - 1)/band_rows;
+  std::optional<ThreadPool> pool;
+  if (options.threads != 1 && num_bands > 1) {
+    pool.emplace(options.threads);
+  }
+  int wave = pool ? 2*pool->num_threads() : 1;
+  std::vector<internal::PngBand> bands(std::min(wave, num_bands));
+  uLong adler = adler32(0, nullptr, 0);
+  for (int b0 = 0; b0 < num_bands; b0 += wave) {
+    int count = std::min(wave, num_bands - b0);
+    for (int i = 0; i < count; i++) {
+      bands[i].y0 = (b0 + i)*band_rows;
+      bands[i].y1 = std::min(height, bands[i].y0 + band_rows);
+    }
+    if (pool) {
+      TaskGroup group;
+      for (int i = 0; i < count; i++) {
+        pool->Run(group, [&, i] {
+          internal::DeflatePngBand(image, options, b0 + i == num_bands - 1, bands[i]);
+        });
+      }
+      pool->Wait(group);
+    } else {
+      internal::DeflatePngBand(image, options, b0 == num_bands - 1, bands[0]);
+    }
+    for (int i = 0; i < count; i++) {
+      internal::PngBand& band = bands[i];
+      if (!band.ok) {
+        return Status{EIO, "error deflating " + filename};
+      }
+      adler = adler32_combine(adler, band.adler, band.raw_size);
+      std::vector<uint8_t> trailer;
+      if (b0 + i == num_bands - 1) {
+        internal::AppendBigEndian32(trailer, uint32_t(adler));
+      }
+      internal::WritePngChunk(outfile, "IDAT", b0 + i == 0 ? zlib_header : std::vector<uint8_t>{},
+                              band.deflated.data(), band.deflated.size(), trailer);
+    }
+  }
+  internal::WritePngChunk(outfile, "IEND", {}, nullptr, 0, {});
+  outfile.close();
+  if (!outfile) {
+    return Status{EIO, "error writing " + filename};
+  }
+  return Status{0, ""};
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_PNG_HPP__
@@ -3,14 +3,20 @@
 #ifndef __CHAOS_POINT_HPP__
 #define __CHAOS_POINT_HPP__
 
+#include <cmath>
+
 namespace chaos {
 
-struct Point2 {
-  Point2(double x_, double y_) : x(x_), y(y_) {}
-  double x;
-  double y;
+// A point with coordinates of type CoordT, e.g. double or DoubleDouble.
+template <typename CoordT>
+struct BasicPoint2 {
+  BasicPoint2(CoordT x_, CoordT y_) : x(x_), y(y_) {}
+  CoordT x;
+  CoordT y;
 };
 
+using Point2 = BasicPoint2<double>;
+
 inline double Dist(Point2 a, Point2 b) {
   double delta_x = b.x - a.x;
   double delta_y = b.y - a.y;
@@ -0,0 +1,260 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_QUADTREE_IMAGE_HPP__
+#define __CHAOS_QUADTREE_IMAGE_HPP__
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "range.hpp"
+#include "status.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace chaos {
+
+namespace internal {
+
+// Rasterize hands out rows to threads in bands of this many.
+constexpr int kQuadtreeBandRows = 64;
+// WriteQuadtreePnm rasterizes bands of about this many bytes at a time.
+constexpr size_t kQuadtreeExportBytes = size_t(16) << 20;
+
+}  // namespace internal
+
+// A QuadtreeImage2d stores an image as a region quadtree: the square that
+// holds it is split into quadrants only where they differ, and each leaf is a
+// square of one value. A fill_rect that covers a node collapses it to a single
+// leaf, so images made of large uniform squares, like Cantor dust, take memory
+// and fill time in proportion to the number of squares rather than their
+// area. Reads descend the tree. Rasterize turns the tree back into pixels.
+//
+// Writes are not safe to make from several threads at once, so render into
+// it with threads = 1. Reads and Rasterize may run concurrently.
+template <typename PixelT = bool>
+class QuadtreeImage2d {
+  public:
+    using pixel_type = PixelT;
+
+    QuadtreeImage2d(int width, int height) : width_(width), height_(height) {
+      size_ = 1;
+      while (size_ < width || size_ < height) {
+        size_ *= 2;
+      }
+      nodes_.push_back(Node{});
+    }
+
+    void write(int x, int y, pixel_type value) {
+      fill_rect(Range2d(x, y, x+1, y+1), value);
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      fill_rect(Range2d(x0, y, x1, y+1), value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      if (range.x0 < range.x1 && range.y0 < range.y1) {
+        FillNode(0, 0, 0, size_, range, value);
+      }
+    }
+    pixel_type read(int x, int y) const {
+      int32_t node = 0;
+      int nx = 0;
+      int ny = 0;
+      int size = size_;
+      while (nodes_[node].children >= 0) {
+        size /= 2;
+        int quadrant = (x >= nx + size) + 2*(y >= ny + size);
+        nx += (quadrant & 1)*size;
+        ny += (quadrant >> 1)*size;
+        node = nodes_[node].children + quadrant;
+      }
+      return nodes_[node].value;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+
+    // Returns the number of nodes in use, each of which takes a few bytes.
+    size_t num_nodes() const {
+      return nodes_.size() - 4*free_groups_.size();
+    }
+    // Sets every pixel to pixel_type{} and frees every node.
+    void Clear() {
+      nodes_.assign(1, Node{});
+      free_groups_.clear();
+    }
+
+    // Writes the pixels of region to dest, with region's top-left corner at
+    // (0, 0) of dest, one FillRect per leaf. Bands of rows, each made of
+    // whole subtrees where possible, are rasterized in parallel when
+    // threads != 1; dest must then accept concurrent writes to rows at least
+    // a band apart, as ParallelForRows arranges.
+    template <Image2dWritable DestT>
+    void Rasterize(Range2d region, DestT& dest, int threads = 1) const {
+      std::optional<ThreadPool> pool;
+      if (threads != 1) {
+        pool.emplace(threads);
+      }
+      Rasterize(region, dest, pool ? &*pool : nullptr);
+    }
+    template <Image2dWritable DestT>
+    void Rasterize(Range2d region, DestT& dest, ThreadPool* pool) const {
+      region = Intersect(region, Range2d(width_, height_));
+      if (region.empty()) {
+        return;
+      }
+      auto rasterize_rows = [&](int row0, int row1) {
+        Range2d band(region.x0, region.y0 + row0, region.x1, region.y0 + row1);
+        RasterizeNode(0, 0, 0, size_, band, region.x0, region.y0, dest);
+      };
+      if (pool == nullptr) {
+        rasterize_rows(0, region.height());
+        return;
+      }
+      ParallelForRows(*pool, region.height(), internal::kQuadtreeBandRows, rasterize_rows);
+    }
+
+  private:
+    // A leaf when children < 0; otherwise its quadrants, top-left, top-right,
+    // bottom-left and bottom-right, are nodes children to children + 3.
+    struct Node {
+      int32_t children = -1;
+      PixelT value{};
+    };
+
+    static bool Overlaps(const Range2d& range, int nx, int ny, int size) {
+      return range.x0 < nx + size && range.x1 > nx && range.y0 < ny + size && range.y1 > ny;
+    }
+
+    // Makes node a leaf of value, freeing its descendants.
+    void MakeLeaf(int32_t node, pixel_type value) {
+      FreeChildren(node);
+      nodes_[node].value = value;
+    }
+    void FreeChildren(int32_t node) {
+      int32_t children = nodes_[node].children;
+      if (children < 0) {
+        return;
+      }
+      for (int q = 0; q < 4; q++) {
+        FreeChildren(children + q);
+      }
+      free_groups_.push_back(children);
+      nodes_[node].children = -1;
+    }
+    // Splits a leaf into four leaves of its value.
+    void Split(int32_t node) {
+      int32_t children;
+      if (!free_groups_.empty()) {
+        children = free_groups_.back();
+        free_groups_.pop_back();
+      } else {
+        children = int32_t(nodes_.size());
+        nodes_.resize(nodes_.size() + 4);
+      }
+      for (int q = 0; q < 4; q++) {
+        nodes_[children + q] = Node{-1, nodes_[node].value};
+      }
+      nodes_[node].children = children;
+    }
+
+    void FillNode(int32_t node, int nx, int ny, int size, const Range2d& range, pixel_type value) {
+      if (range.x0 <= nx && range.y0 <= ny && range.x1 >= nx + size && range.y1 >= ny + size) {
+        MakeLeaf(node, value);
+        return;
+      }
+      if (nodes_[node].children < 0) {
+        if (nodes_[node].value == value) {
+          return;
+        }
+        Split(node);
+      }
+      int half = size/2;
+      for (int q = 0; q < 4; q++) {
+        int cx = nx + (q & 1)*half;
+        int cy = ny + (q >> 1)*half;
+        if (Overlaps(range, cx, cy, half)) {
+          FillNode(nodes_[node].children + q, cx, cy, half, range, value);
+        }
+      }
+      // Collapses quadrants that have become one leaf value.
+      int32_t children = nodes_[node].children;
+      for (int q = 0; q < 4; q++) {
+        if (nodes_[children + q].children >= 0 || !(nodes_[children + q].value == nodes_[children].value)) {
+          return;
+        }
+      }
+      MakeLeaf(node, nodes_[children].value);
+    }
+
+    template <Image2dWritable DestT>
+    void RasterizeNode(int32_t node, int nx, int ny, int size, const Range2d& band, int offset_x, int offset_y, DestT& dest) const {
+      const Node& n = nodes_[node];
+      if (n.children < 0) {
+        Range2d leaf = Intersect(band, Range2d(nx, ny, nx + size, ny + size));
+        internal::FillRect(dest, Range2d(leaf.x0 - offset_x, leaf.y0 - offset_y, leaf.x1 - offset_x, leaf.y1 - offset_y),
+                           typename DestT::pixel_type(n.value));
+        return;
+      }
+      int half = size/2;
+      for (int q = 0; q < 4; q++) {
+        int cx = nx + (q & 1)*half;
+        int cy = ny + (q >> 1)*half;
+        if (Overlaps(band, cx, cy, half)) {
+          RasterizeNode(n.children + q, cx, cy, half, band, offset_x, offset_y, dest);
+        }
+      }
+    }
+
+    int width_;
+    int height_;
+    // The side of the square the tree covers, a power of two.
+    int size_;
+    // Node 0 is the root.
+    std::vector<Node> nodes_;
+    // The first nodes of groups of four that are free for reuse.
+    std::vector<int32_t> free_groups_;
+};
+
+// Writes image as a binary PGM (P5) or bit-packed PBM (P4), rasterizing it a
+// band of rows at a time, so the pixels are never all in memory at once.
+// Each band is rasterized in parallel when threads != 1.
+template <typename PixelT>
+Status WriteQuadtreePnm(const QuadtreeImage2d<PixelT>& image, const std::string& filename, PnmFormat format, int threads = 1) {
+  int width = image.width();
+  int height = image.height();
+  std::optional<ThreadPool> pool;
+  if (threads != 1) {
+    pool.emplace(threads);
+  }
+  ThreadPool* pool_ptr = pool ? &*pool : nullptr;
+  size_t bytes_per_row = std::max<size_t>(1, format == PnmFormat::kPbm ? internal::PbmRowBytes(width) : size_t(width));
+  int band_rows = int(std::clamp<size_t>(internal::kQuadtreeExportBytes/bytes_per_row, 1, std::max(1, height)));
+  PnmStreamWriter writer(filename, format, width, height);
+  auto write_bands = [&](auto& band) {
+    for (int y0 = 0; y0 < height; y0 += band_rows) {
+      int y1 = std::min(height, y0 + band_rows);
+      image.Rasterize(Range2d(0, y0, width, y1), band, pool_ptr);
+      writer.WriteRows(band, y1 - y0);
+    }
+  };
+  if (format == PnmFormat::kPbm) {
+    BitImage2d band(width, band_rows);
+    write_bands(band);
+  } else {
+    Image2d<uint8_t> band(width, band_rows);
+    write_bands(band);
+  }
+  return writer.Close();
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_QUADTREE_IMAGE_HPP__
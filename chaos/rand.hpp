@@ -3,6 +3,8 @@
 #ifndef __CHAOS_RAND_HPP__
 #define __CHAOS_RAND_HPP__
 
+#include <array>
+#include <cstdint>
 #include <random>
 
 namespace chaos {
@@ -10,17 +12,194 @@ namespace chaos {
 template <typename ValueT>
 class Random {
   public:
-    Random() : device_(), gen_(device_()), dist_(0, 1) {}
+    Random() : gen_(std::random_device()()), dist_(0, 1) {}
     explicit Random(unsigned int seed) : gen_(seed), dist_(0, 1) {}
     double ZeroToOne() {
       return dist_(gen_);
     }
   private:
-   std::random_device device_;
    std::mt19937 gen_;
    std::uniform_real_distribution<ValueT> dist_;
 };
 
+// The Philox4x32-10 block function from Salmon et al., "Parallel Random
+// Numbers: As Easy as 1, 2, 3". It maps a 128-bit counter and a 64-bit key to
+// 128 random bits.
+struct Philox4x32 {
+  using Counter = std::array<uint32_t, 4>;
+  using Key = std::array<uint32_t, 2>;
+  static constexpr int kRounds = 10;
+
+  static Counter Generate(Counter ctr, Key key) {
+    for (int round = 0; round < kRounds; round++) {
+      if (round > 0) {
+        key[0] += 0x9E3779B9;
+        key[1] += 0xBB67AE85;
+      }
+      uint64_t product0 = uint64_t(0xD2511F53) * ctr[0];
+      uint64_t product1 = uint64_t(0xCD9E8D57) * ctr[2];
+      ctr = Counter{
+        uint32_t(product1 >> 32) ^ ctr[1] ^ key[0],
+        uint32_t(product1),
+        uint32_t(product0 >> 32) ^ ctr[3] ^ key[1],
+        uint32_t(product0),
+      };
+    }
+    return ctr;
+  }
+};
+
+// A CounterRandom produces uniform values as a pure function of
+// (seed, stream, index), with no state carried from one value to the next.
+// Values can therefore be generated in any order, on any thread, and
+// regenerated later, which sequential generators like Random cannot do.
+class CounterRandom {
+  public:
+    explicit CounterRandom(uint64_t seed) : key_{uint32_t(seed), uint32_t(seed >> 32)} {}
+
+    // Returns the uniform value in [0, 1) at index of stream.
+    double ZeroToOne(uint64_t stream, uint64_t index) const {
+      Philox4x32::Counter block = Philox4x32::Generate(BlockCounter(stream, index/2), key_);
+      return (index % 2 == 0) ? ToUnit(block[0], block[1]) : ToUnit(block[2], block[3]);
+    }
+
+    // Sets out[i] = ZeroToOne(stream, first + i) for i in [0, n). Blocks are
+    // generated several at a time in independent lanes, which the compiler
+    // turns into vector instructions.
+    void FillZeroToOne(uint64_t stream, uint64_t first, double* out, int n) const {
+      uint64_t end = first + n;
+      for (uint64_t block = first/2; 2*block < end; block += kLanes) {
+        Lanes c = GenerateLanes(stream, block);
+        for (int l = 0; l < kLanes; l++) {
+          uint64_t index = 2*(block + l);
+          if (index >= first && index < end) {
+            out[index - first] = ToUnit(c[0][l], c[1][l]);
+          }
+          if (index + 1 >= first && index + 1 < end) {
+            out[index + 1 - first] = ToUnit(c[2][l], c[3][l]);
+          }
+        }
+      }
+    }
+
+    // Sets out[i] to 32 random bits for i in [0, n), taking all four words of
+    // each block rather than the two values of FillZeroToOne, for callers that
+    // need no more precision than that. Word index of stream is made of the
+    // four words of block index/4.
+    void FillBits(uint64_t stream, uint64_t first, uint32_t* out, int n) const {
+      uint64_t end = first + n;
+      for (uint64_t block = first/4; 4*block < end; block += kLanes) {
+        Lanes c = GenerateLanes(stream, block);
+        for (int l = 0; l < kLanes; l++) {
+          for (int word = 0; word < 4; word++) {
+            uint64_t index = 4*(block + l) + word;
+            if (index >= first && index < end) {
+              out[index - first] = c[word][l];
+            }
+          }
+        }
+      }
+    }
+
+  private:
+    static constexpr int kLanes = 8;
+    // Word w of blocks [block, block + kLanes), with lane l in element [w][l].
+    using Lanes = std::array<std::array<uint32_t, kLanes>, 4>;
+
+    Lanes GenerateLanes(uint64_t stream, uint64_t block) const {
+      uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+      for (int l = 0; l < kLanes; l++) {
+        c0[l] = uint32_t(block + l);
+        c1[l] = uint32_t((block + l) >> 32);
+        c2[l] = uint32_t(stream);
+        c3[l] = uint32_t(stream >> 32);
+      }
+      uint32_t k0 = key_[0];
+      uint32_t k1 = key_[1];
+      for (int round = 0; round < Philox4x32::kRounds; round++) {
+        if (round > 0) {
+          k0 += 0x9E3779B9;
+          k1 += 0xBB67AE85;
+        }
+        for (int l = 0; l < kLanes; l++) {
+          uint64_t product0 = uint64_t(0xD2511F53) * c0[l];
+          uint64_t product1 = uint64_t(0xCD9E8D57) * c2[l];
+          uint32_t n0 = uint32_t(product1 >> 32) ^ c1[l] ^ k0;
+          uint32_t n2 = uint32_t(product0 >> 32) ^ c3[l] ^ k1;
+          c1[l] = uint32_t(product1);
+          c3[l] = uint32_t(product0);
+          c0[l] = n0;
+          c2[l] = n2;
+        }
+      }
+      Lanes lanes;
+      for (int l = 0; l < kLanes; l++) {
+        lanes[0][l] = c0[l];
+        lanes[1][l] = c1[l];
+        lanes[2][l] = c2[l];
+        lanes[3][l] = c3[l];
+      }
+      return lanes;
+    }
+    static Philox4x32::Counter BlockCounter(uint64_t stream, uint64_t block) {
+      return Philox4x32::Counter{uint32_t(block), uint32_t(block >> 32), uint32_t(stream), uint32_t(stream >> 32)};
+    }
+    // Converts the top 53 of 64 random bits to a double in [0, 1).
+    static double ToUnit(uint32_t lo, uint32_t hi) {
+      uint64_t bits = (uint64_t(hi) << 32) | lo;
+      return double(bits >> 11) * 0x1.0p-53;
+    }
+    Philox4x32::Key key_;
+};
+
+// A LaneRandom runs kLanes independent xoshiro128** generators side by side,
+// so that one call produces a word for each lane in a loop the compiler
+// vectorizes. It is far cheaper per word than CounterRandom, but sequential.
+// It is split off a CounterRandom: each stream of the CounterRandom seeds a
+// different set of lanes, so parallel work can still be divided into streams
+// that give the same results in any order.
+template <int kLanes>
+class LaneRandom {
+  public:
+    LaneRandom(const CounterRandom& seeder, uint64_t stream) {
+      uint32_t words[4*kLanes];
+      seeder.FillBits(stream, 0, words, 4*kLanes);
+      for (int l = 0; l < kLanes; l++) {
+        s0_[l] = words[4*l];
+        s1_[l] = words[4*l + 1];
+        s2_[l] = words[4*l + 2];
+        s3_[l] = words[4*l + 3];
+        // The all-zero state is the one xoshiro cannot leave.
+        if ((s0_[l] | s1_[l] | s2_[l] | s3_[l]) == 0) {
+          s0_[l] = 1;
+        }
+      }
+    }
+
+    // Sets out[l] to the next 32 random bits of lane l.
+    void Next(uint32_t* out) {
+      for (int l = 0; l < kLanes; l++) {
+        out[l] = Rotl(s1_[l]*5, 7)*9;
+        uint32_t t = s1_[l] << 9;
+        s2_[l] ^= s0_[l];
+        s3_[l] ^= s1_[l];
+        s1_[l] ^= s2_[l];
+        s0_[l] ^= s3_[l];
+        s2_[l] ^= t;
+        s3_[l] = Rotl(s3_[l], 11);
+      }
+    }
+
+  private:
+    static uint32_t Rotl(uint32_t x, int k) {
+      return (x << k) | (x >> (32 - k));
+    }
+    uint32_t s0_[kLanes];
+    uint32_t s1_[kLanes];
+    uint32_t s2_[kLanes];
+    uint32_t s3_[kLanes];
+};
+
 } // namespace chaos
 
 #endif  // __CHAOS_RAND_HPP__
@@ -3,15 +3,17 @@
 #ifndef __CHAOS_RANGE_HPP__
 #define __CHAOS_RANGE_HPP__
 
+#include <algorithm>
+
 namespace chaos {
 
 template <typename ValueT>
 struct Range {
-  Range(ValueT x0_, ValueT x1_) : x0(x0_), x1(x1_) {}
-  explicit Range(ValueT x1_) : x0(0), x1(x1_) {}
+  constexpr Range(ValueT x0_, ValueT x1_) : x0(x0_), x1(x1_) {}
+  constexpr explicit Range(ValueT x1_) : x0(0), x1(x1_) {}
   ValueT x0;
   ValueT x1;
-  ValueT width() const {return x1 - x0;}
+  constexpr ValueT width() const {return x1 - x0;}
 };
 
 struct Range2d {
@@ -26,8 +28,16 @@ struct Range2d {
   int y1;
   int width() const {return x1 - x0;}
   int height() const {return y1 - y0;}
+  bool empty() const {return x1 <= x0 || y1 <= y0;}
 };
 
+// Returns the overlap of a and b, which is empty if they do not overlap.
+inline Range2d Intersect(Range2d a, Range2d b) {
+  int x0 = std::max(a.x0, b.x0);
+  int y0 = std::max(a.y0, b.y0);
+  return Range2d(x0, y0, std::max(x0, std::min(a.x1, b.x1)), std::max(y0, std::min(a.y1, b.y1)));
+}
+
 } // namespace chaos
 
 #endif // __CHAOS_RANGE_HPP__
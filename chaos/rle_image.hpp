@@ -0,0 +1,194 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_RLE_IMAGE_HPP__
+#define __CHAOS_RLE_IMAGE_HPP__
+
+#include "image.hpp"
+#include "range.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace chaos {
+
+// An RleImage2d stores each row as a sorted list of runs of equal pixels;
+// pixels outside every run are pixel_type{}. Fractals made of long constant
+// runs then cost memory and fill time in proportion to their number of runs
+// rather than their area. Runs never overlap, and touching runs always
+// differ in value.
+//
+// Identical rows share their runs: copy_row and fill_rect make rows point at
+// the same list, and a row's list is copied only when it is written while
+// shared. Writes to different rows may come from different threads, as long
+// as no thread is copying one of those rows at the same time.
+template <typename PixelT>
+class RleImage2d {
+  public:
+    using pixel_type = PixelT;
+    using Run = PixelRun<PixelT>;
+
+    RleImage2d(int width, int height) : width_(width), height_(height), rows_(height) {}
+
+    void write(int x, int y, pixel_type value) {
+      write_span(x, x+1, y, value);
+    }
+    // Sets [x0, x1) of row y to value, in time linear in the runs of the row.
+    // Spans that start at or after the end of the row's last run, as when a
+    // row is drawn from left to right, take constant time.
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      bool blank = (value == pixel_type{});
+      if (x0 >= x1 || (blank && row_runs(y).empty())) {
+        return;
+      }
+      std::vector<Run>& runs = MutableRow(y);
+      if (runs.empty() || x0 >= runs.back().x1) {
+        if (blank) {
+          return;
+        }
+        if (!runs.empty() && x0 == runs.back().x1 && runs.back().value == value) {
+          runs.back().x1 = x1;
+        } else {
+          runs.push_back(Run{x0, x1, value});
+        }
+        return;
+      }
+      // Runs [first, last) overlap or touch [x0, x1).
+      auto first = std::lower_bound(runs.begin(), runs.end(), x0, [](const Run& run, int x) {
+        return run.x1 < x;
+      });
+      auto last = std::upper_bound(first, runs.end(), x1, [](int x, const Run& run) {
+        return x < run.x0;
+      });
+      // What survives of those runs: the parts left of x0 and right of x1, or
+      // with the same value, the parts that merge with the new run.
+      Run merged{x0, x1, value};
+      Run left{0, 0, value};
+      Run right{0, 0, value};
+      bool has_left = false;
+      bool has_right = false;
+      if (first != last) {
+        const Run& front = *first;
+        const Run& back = *(last - 1);
+        if (front.x0 < x0 || (front.x0 == x0 && front.value == value)) {
+          if (front.value == value && !blank) {
+            merged.x0 = front.x0;
+          } else if (front.x0 < x0) {
+            left = Run{front.x0, x0, front.value};
+            has_left = true;
+          }
+        }
+        if (back.x1 > x1 || (back.x1 == x1 && back.value == value)) {
+          if (back.value == value && !blank) {
+            merged.x1 = back.x1;
+          } else if (back.x1 > x1) {
+            right = Run{x1, back.x1, back.value};
+            has_right = true;
+          }
+        }
+      }
+      Run replacement[3];
+      int count = 0;
+      if (has_left) {
+        replacement[count++] = left;
+      }
+      if (!blank) {
+        replacement[count++] = merged;
+      }
+      if (has_right) {
+        replacement[count++] = right;
+      }
+      ptrdiff_t removed = last - first;
+      ptrdiff_t at = first - runs.begin();
+      if (count <= removed) {
+        std::copy(replacement, replacement + count, first);
+        runs.erase(first + count, last);
+      } else {
+        std::copy(replacement, replacement + removed, first);
+        runs.insert(runs.begin() + at + removed, replacement + removed, replacement + count);
+      }
+    }
+    // Sets range to value. Rows that shared the runs of the first row of
+    // range before the write are pointed at its result rather than written
+    // again, so tall rectangles over identical rows, like the bars drawn by
+    // BarImageWriter, cost one row write and a pointer copy per row.
+    void fill_rect(Range2d range, pixel_type value) {
+      if (range.y0 >= range.y1) {
+        return;
+      }
+      // Kept alive by the rows that still share it, if there are any.
+      const std::vector<Run>* before = rows_[range.y0].get();
+      write_span(range.x0, range.x1, range.y0, value);
+      for (int y = range.y0 + 1; y < range.y1; y++) {
+        if (rows_[y].get() == before) {
+          rows_[y] = rows_[range.y0];
+        } else {
+          write_span(range.x0, range.x1, y, value);
+        }
+      }
+    }
+    pixel_type read(int x, int y) const {
+      const std::vector<Run>& runs = row_runs(y);
+      auto it = std::upper_bound(runs.begin(), runs.end(), x, [](int x, const Run& run) {
+        return x < run.x1;
+      });
+      return (it != runs.end() && it->x0 <= x) ? it->value : pixel_type{};
+    }
+    const std::vector<Run>& row_runs(int y) const {
+      static const std::vector<Run> kEmpty;
+      return rows_[y] ? *rows_[y] : kEmpty;
+    }
+    // Makes row dst_y a copy of row src_y, sharing its runs until either row
+    // is written.
+    void copy_row(int src_y, int dst_y) {
+      rows_[dst_y] = rows_[src_y];
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+
+    // Returns the number of runs in the image, counting shared rows once
+    // per row.
+    size_t num_runs() const {
+      size_t total = 0;
+      for (int y = 0; y < height_; y++) {
+        total += row_runs(y).size();
+      }
+      return total;
+    }
+    // Sets every pixel to pixel_type{}.
+    void Clear() {
+      std::fill(rows_.begin(), rows_.end(), nullptr);
+    }
+
+  private:
+    // Returns row y's runs for writing, first giving it its own copy if it
+    // shares them.
+    std::vector<Run>& MutableRow(int y) {
+      std::shared_ptr<std::vector<Run>>& row = rows_[y];
+      if (!row) {
+        row = std::make_shared<std::vector<Run>>();
+      } else if (row.use_count() > 1) {
+        row = std::make_shared<std::vector<Run>>(*row);
+      } else {
+        // Rows that shared these runs may have just let go of them on other
+        // threads; their reads must come before our writes.
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+      return *row;
+    }
+
+    int width_;
+    int height_;
+    // Null for rows with no runs.
+    std::vector<std::shared_ptr<std::vector<Run>>> rows_;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_RLE_IMAGE_HPP__
@@ -0,0 +1,223 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_STATS_HPP__
+#define __CHAOS_STATS_HPP__
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "range.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace chaos {
+
+// Concept RenderStatsCollector is satisfied by types that renderers can report
+// their work to. Draw* functions and writers that accept a collector default
+// to NullRenderStats, which compiles away entirely.
+template <typename StatsT>
+concept RenderStatsCollector = requires(StatsT stats) {
+  // A recursion node at the given depth was entered.
+  stats.Visit(0);
+  // A node at the given depth stopped recursing because it shrank below a
+  // pixel.
+  stats.Cutoff(0);
+  // pixels were written, redundant of which had already been written.
+  stats.Write(int64_t(0), int64_t(0));
+  // A pixel that a recursion leaf drew with SafeWrite or SafeFill fell
+  // outside the image. Larger fills, lines and stamped instances are clipped
+  // without being counted.
+  stats.RejectWrite();
+};
+
+// Collects nothing.
+struct NullRenderStats {
+  void Visit(int) {}
+  void Cutoff(int) {}
+  void Write(int64_t, int64_t) {}
+  void RejectWrite() {}
+};
+
+// Counts the work done by a render. Counters are atomic, so one RenderStats
+// can be shared by the threads of a parallel render. Pixel writes are only
+// counted when the destination is wrapped in a StatsImage1d or StatsImage2d.
+class RenderStats {
+  public:
+    // Depths at or beyond this are counted together.
+    static constexpr int kMaxDepth = 64;
+
+    void Visit(int depth) {
+      visits_[Bucket(depth)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void Cutoff(int depth) {
+      cutoffs_[Bucket(depth)].fetch_add(1, std::memory_order_relaxed);
+    }
+    void Write(int64_t pixels, int64_t redundant) {
+      pixel_writes_.fetch_add(pixels, std::memory_order_relaxed);
+      redundant_writes_.fetch_add(redundant, std::memory_order_relaxed);
+    }
+    void RejectWrite() {
+      rejected_writes_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    int64_t visits(int depth) const {
+      return visits_[Bucket(depth)].load(std::memory_order_relaxed);
+    }
+    int64_t cutoffs(int depth) const {
+      return cutoffs_[Bucket(depth)].load(std::memory_order_relaxed);
+    }
+    int64_t total_visits() const {
+      return Sum(visits_);
+    }
+    int64_t total_cutoffs() const {
+      return Sum(cutoffs_);
+    }
+    int64_t pixel_writes() const {
+      return pixel_writes_.load(std::memory_order_relaxed);
+    }
+    int64_t redundant_writes() const {
+      return redundant_writes_.load(std::memory_order_relaxed);
+    }
+    int64_t rejected_writes() const {
+      return rejected_writes_.load(std::memory_order_relaxed);
+    }
+    // Pixel writes per distinct pixel written; 1 means no overdraw.
+    double overdraw_ratio() const {
+      int64_t distinct = pixel_writes() - redundant_writes();
+      return distinct == 0 ? 0.0 : double(pixel_writes())/distinct;
+    }
+
+    void Report(std::ostream& out) const {
+      out << "depth        nodes      cutoffs\n";
+      for (int depth = 0; depth < kMaxDepth; depth++) {
+        if (visits(depth) == 0 && cutoffs(depth) == 0) {
+          continue;
+        }
+        out << (depth == kMaxDepth - 1 ? ">=" : "  ") << depth;
+        out << "\t" << visits(depth) << "\t" << cutoffs(depth) << "\n";
+      }
+      out << "total nodes:      " << total_visits() << "\n";
+      out << "total cutoffs:    " << total_cutoffs() << "\n";
+      out << "pixel writes:     " << pixel_writes() << "\n";
+      out << "redundant writes: " << redundant_writes() << "\n";
+      out << "overdraw ratio:   " << overdraw_ratio() << "\n";
+      out << "rejected writes:  " << rejected_writes() << "\n";
+    }
+
+  private:
+    static int Bucket(int depth) {
+      return std::clamp(depth, 0, kMaxDepth - 1);
+    }
+    static int64_t Sum(const std::atomic<int64_t> (&counters)[kMaxDepth]) {
+      int64_t total = 0;
+      for (const auto& counter : counters) {
+        total += counter.load(std::memory_order_relaxed);
+      }
+      return total;
+    }
+    std::atomic<int64_t> visits_[kMaxDepth] = {};
+    std::atomic<int64_t> cutoffs_[kMaxDepth] = {};
+    std::atomic<int64_t> pixel_writes_{0};
+    std::atomic<int64_t> redundant_writes_{0};
+    std::atomic<int64_t> rejected_writes_{0};
+};
+
+// A StatsImage1d passes writes through to an underlying image and reports
+// them to a collector, remembering which pixels have been written so that
+// repeated writes are counted as overdraw.
+template <Image1dWritable UnderlyingImageT, RenderStatsCollector StatsT = RenderStats>
+class StatsImage1d {
+  public:
+    using underlying_type = UnderlyingImageT;
+    using pixel_type = typename underlying_type::pixel_type;
+    StatsImage1d(underlying_type& underlying, StatsT& stats)
+        : underlying_(&underlying), stats_(&stats), written_(underlying.width()) {}
+
+    void write(int x, pixel_type value) {
+      Record(x, x+1);
+      underlying_->write(x, value);
+    }
+    void write_span(int x0, int x1, pixel_type value) {
+      Record(x0, x1);
+      internal::WriteSpan(*underlying_, x0, x1, value);
+    }
+    pixel_type read(int x) const requires Image1dReadable<underlying_type> {
+      return underlying_->read(x);
+    }
+    Range<int> clip_range() const {
+      return ClipRange1d(*underlying_);
+    }
+    int width() const {
+      return underlying_->width();
+    }
+  private:
+    void Record(int x0, int x1) {
+      int64_t redundant = 0;
+      for (int x = x0; x < x1; x++) {
+        redundant += written_[x];
+        written_[x] = true;
+      }
+      stats_->Write(x1 - x0, redundant);
+    }
+    underlying_type* underlying_;
+    StatsT* stats_;
+    std::vector<bool> written_;
+};
+
+// The 2-D counterpart of StatsImage1d. Rows of the written-pixel bitmap do not
+// share words, so the image is as safe for parallel renders as the
+// underlying image.
+template <Image2dWritable UnderlyingImageT, RenderStatsCollector StatsT = RenderStats>
+class StatsImage2d {
+  public:
+    using underlying_type = UnderlyingImageT;
+    using pixel_type = typename underlying_type::pixel_type;
+    StatsImage2d(underlying_type& underlying, StatsT& stats)
+        : underlying_(&underlying), stats_(&stats), written_(underlying.width(), underlying.height()) {}
+
+    void write(int x, int y, pixel_type value) {
+      Record(x, x+1, y);
+      underlying_->write(x, y, value);
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      Record(x0, x1, y);
+      internal::WriteSpan(*underlying_, x0, x1, y, value);
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      for (int y = range.y0; y < range.y1; y++) {
+        Record(range.x0, range.x1, y);
+      }
+      internal::FillRect(*underlying_, range, value);
+    }
+    pixel_type read(int x, int y) const requires Image2dReadable<underlying_type> {
+      return underlying_->read(x, y);
+    }
+    Range2d clip_range() const {
+      return ClipRange(*underlying_);
+    }
+    int width() const {
+      return underlying_->width();
+    }
+    int height() const {
+      return underlying_->height();
+    }
+  private:
+    void Record(int x0, int x1, int y) {
+      int64_t redundant = 0;
+      for (int x = x0; x < x1; x++) {
+        redundant += written_.read(x, y);
+      }
+      written_.write_span(x0, x1, y, true);
+      stats_->Write(x1 - x0, redundant);
+    }
+    underlying_type* underlying_;
+    StatsT* stats_;
+    BitImage2d written_;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_STATS_HPP__
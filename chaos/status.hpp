@@ -3,13 +3,18 @@
 #ifndef __CHAOS_STATUS_HPP__
 #define __CHAOS_STATUS_HPP__
 
+#include <string>
+
 namespace chaos {
 
+// A Status reports the outcome of an operation that can fail. A code of 0
+// means success.
 struct Status {
   int code;
   std::string message;
+  bool ok() const {return code == 0;}
 };
 
 } // namespace chaos {
 
-#endif // __CHAOS_IMAGE_H__
+#endif // __CHAOS_STATUS_HPP__
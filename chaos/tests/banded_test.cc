@@ -0,0 +1,102 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+//
+// Checks that RenderBandedPgm and RenderBandedPbm write the same bytes as
+// WriteBinaryPgm and WritePbm of the same picture rendered whole, for band
+// heights that do and do not divide the image, including out-of-range ones.
+// Prints each mismatch and exits nonzero if there are any.
+
+#include "banded.hpp"
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "cantor/cantor.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace chaos;
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+std::string TempPath(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+std::vector<char> ReadFile(const std::string& filename) {
+  std::ifstream in(filename, std::ios::binary);
+  return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+// Draws pixels of several values for PGM, which PBM turns into black and white.
+template <Image2dWritable ImageT>
+void Draw(ImageT& image) {
+  Cantor2dOptions options{.max_iterations = 3, .draw_all_iterations = true};
+  DrawCantor2d(image, options);
+  Range2d clip = ClipRange(image);
+  for (int y = clip.y0; y < clip.y1; y++) {
+    for (int x = clip.x0; x < clip.x1; x++) {
+      if ((x + y) % 5 == 0) {
+        image.write(x, y, uint8_t(x*7 + y));
+      }
+    }
+  }
+}
+
+void CheckSame(const char* format, int width, int height, int band_height, const std::string& expected_file,
+               const std::string& actual_file) {
+  cases++;
+  std::vector<char> expected = ReadFile(expected_file);
+  std::vector<char> actual = ReadFile(actual_file);
+  if (expected.empty() || expected != actual) {
+    std::printf("FAIL %s %dx%d band_height=%d: wrote %zu bytes, want %zu bytes matching the whole render\n",
+                format, width, height, band_height, actual.size(), expected.size());
+    failures++;
+  }
+}
+
+void Check(int width, int height, int band_height) {
+  std::string expected_file = TempPath("chaos_banded_test_expected");
+  std::string actual_file = TempPath("chaos_banded_test_actual");
+
+  Image2d<uint8_t> gray(width, height);
+  Draw(gray);
+  WriteBinaryPgm(gray, expected_file);
+  RenderBandedPgm(actual_file, width, height, band_height, [](auto& image) { Draw(image); });
+  CheckSame("P5", width, height, band_height, expected_file, actual_file);
+
+  BitImage2d bits(width, height);
+  Draw(bits);
+  WritePbm(bits, expected_file);
+  RenderBandedPbm(actual_file, width, height, band_height, [](auto& image) { Draw(image); });
+  CheckSame("P4", width, height, band_height, expected_file, actual_file);
+
+  std::filesystem::remove(expected_file);
+  std::filesystem::remove(actual_file);
+}
+
+}  // namespace
+
+int main(void) {
+  // Widths that do not fill a whole PBM byte, and a single row.
+  const std::vector<std::pair<int, int>> sizes = {{243, 243}, {100, 37}, {81, 1}};
+  for (auto [width, height] : sizes) {
+    for (int band_height : {-3, 0, 1, 7, 32, height, height + 10}) {
+      Check(width, height, band_height);
+    }
+  }
+
+  if (failures > 0) {
+    std::printf("%d of %d cases failed\n", failures, cases);
+    return 1;
+  }
+  std::printf("%d cases passed\n", cases);
+  return 0;
+}
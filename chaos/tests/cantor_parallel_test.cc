@@ -0,0 +1,78 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+//
+// Checks that DrawCantor2d with threads != 1 sets exactly the pixels of a
+// serial render, including on images too flat to split into row bands.
+// Prints each mismatch and exits nonzero if there are any.
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "cantor/cantor.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <vector>
+
+using namespace chaos;
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+template <typename ImageT>
+void Check(const char* image_name, int width, int height, Cantor2dOptions options) {
+  cases++;
+  Cantor2dOptions serial = options;
+  serial.threads = 1;
+  ImageT expected(width, height);
+  ImageT actual(width, height);
+  DrawCantor2d(expected, serial);
+  DrawCantor2d(actual, options);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (expected.read(x, y) != actual.read(x, y)) {
+        std::printf("FAIL DrawCantor2d %s %dx%d max_iterations=%d draw_all_iterations=%d probability=%g threads=%d: "
+                    "pixel (%d, %d) is %d, want %d\n",
+                    image_name, width, height, options.max_iterations, int(options.draw_all_iterations),
+                    options.probability.value_or(-1), options.threads, x, y,
+                    int(actual.read(x, y)), int(expected.read(x, y)));
+        failures++;
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(void) {
+  // Wide, short images, which are too flat to split into row bands, around
+  // the cutoff height, and tall ones that are split.
+  const std::vector<std::pair<int, int>> sizes = {
+    {6561, 1}, {6561, 2}, {6561, 9}, {6561, 27}, {6561, 80}, {6561, 81},
+    {2187, 100}, {729, 729}, {100, 2187}, {1, 6561},
+  };
+  for (auto [width, height] : sizes) {
+    for (int threads : {2, 4}) {
+      for (int depth : {3, INT_MAX}) {
+        for (bool draw_all : {false, true}) {
+          Cantor2dOptions options{.max_iterations = depth, .draw_all_iterations = draw_all, .threads = threads};
+          Check<Image2d<bool>>("Image2d<bool>", width, height, options);
+          Check<BitImage2d>("BitImage2d", width, height, options);
+        }
+      }
+      // Counter-based random dust takes the parallel path too.
+      Cantor2dOptions random{.seed = 7, .probability = 0.6, .threads = threads, .counter_based_random = true};
+      Check<Image2d<bool>>("Image2d<bool>", width, height, random);
+      Check<BitImage2d>("BitImage2d", width, height, random);
+    }
+  }
+
+  if (failures > 0) {
+    std::printf("%d of %d cases failed\n", failures, cases);
+    return 1;
+  }
+  std::printf("%d cases passed\n", cases);
+  return 0;
+}
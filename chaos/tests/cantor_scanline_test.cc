@@ -0,0 +1,116 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+//
+// Checks that the scanline renderers set exactly the pixels the recursive
+// renderers do. Prints each mismatch and exits nonzero if there are any.
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "cantor/cantor.hpp"
+#include "cantor/cantor_scanline.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace chaos;
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+std::string Describe(const Cantor1dOptions& options) {
+  char text[128];
+  std::snprintf(text, sizeof(text), "max_iterations=%d removal=[%g, %g]",
+                options.max_iterations, options.removal_start_ratio, options.removal_end_ratio);
+  return text;
+}
+
+std::string Describe(const Cantor2dOptions& options) {
+  char text[128];
+  std::snprintf(text, sizeof(text), "max_iterations=%d draw_all_iterations=%d threads=%d",
+                options.max_iterations, int(options.draw_all_iterations), options.threads);
+  return text;
+}
+
+void Check1d(int width, const Cantor1dOptions& options) {
+  cases++;
+  Image1d<bool> expected(width);
+  Image1d<bool> actual(width);
+  DrawCantor1d(expected, options);
+  DrawCantor1dScanline(actual, options);
+  for (int x = 0; x < width; x++) {
+    if (expected.read(x) != actual.read(x)) {
+      std::printf("FAIL DrawCantor1dScanline width=%d %s: pixel %d is %d, want %d\n",
+                  width, Describe(options).c_str(), x, int(actual.read(x)), int(expected.read(x)));
+      failures++;
+      return;
+    }
+  }
+}
+
+template <typename ImageT>
+void Check2d(const char* image_name, int width, int height, const Cantor2dOptions& options) {
+  cases++;
+  Cantor2dOptions serial = options;
+  serial.threads = 1;
+  ImageT expected(width, height);
+  ImageT actual(width, height);
+  DrawCantor2d(expected, serial);
+  DrawCantor2dScanline(actual, options);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      if (expected.read(x, y) != actual.read(x, y)) {
+        std::printf("FAIL DrawCantor2dScanline %s %dx%d %s: pixel (%d, %d) is %d, want %d\n",
+                    image_name, width, height, Describe(options).c_str(), x, y,
+                    int(actual.read(x, y)), int(expected.read(x, y)));
+        failures++;
+        return;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(void) {
+  // Powers of 3, whose intervals line up with pixels, and sizes that don't.
+  const std::vector<int> widths = {1, 2, 3, 9, 10, 27, 64, 81, 100, 243, 500, 729, 1000, 2187, 6561};
+  const std::vector<int> depths = {0, 1, 2, 3, 5, INT_MAX};
+  const std::vector<std::pair<double, double>> removals = {
+    {1.0/3.0, 2.0/3.0}, {0.25, 0.5}, {0.1, 0.9}, {0.5, 0.75}, {0.4, 0.45},
+  };
+  for (int width : widths) {
+    for (int depth : depths) {
+      for (auto [start, end] : removals) {
+        Check1d(width, Cantor1dOptions{.max_iterations = depth, .removal_start_ratio = start, .removal_end_ratio = end});
+      }
+    }
+  }
+
+  // Square and non-square canvases, powers of 3 and not.
+  const std::vector<std::pair<int, int>> sizes = {
+    {1, 1}, {3, 3}, {10, 10}, {27, 27}, {81, 81}, {100, 100}, {243, 243}, {729, 729},
+    {243, 81}, {81, 243}, {100, 37}, {37, 100}, {729, 50}, {500, 300}, {2187, 729},
+  };
+  for (auto [width, height] : sizes) {
+    for (int depth : depths) {
+      for (bool draw_all : {false, true}) {
+        for (int threads : {1, 4}) {
+          Cantor2dOptions options{.max_iterations = depth, .draw_all_iterations = draw_all, .threads = threads};
+          Check2d<Image2d<bool>>("Image2d<bool>", width, height, options);
+          Check2d<BitImage2d>("BitImage2d", width, height, options);
+        }
+      }
+    }
+  }
+
+  if (failures > 0) {
+    std::printf("%d of %d cases failed\n", failures, cases);
+    return 1;
+  }
+  std::printf("%d cases passed\n", cases);
+  return 0;
+}
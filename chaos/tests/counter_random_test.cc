@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+//
+// Checks Philox4x32-10 against the Random123 known-answer vectors, and that
+// random dust drawn with counter_based_random sets the same pixels however it
+// is traversed: serially, on several threads, one window at a time, and as a
+// zoom into a sub-square with DrawCantor2dAt, including zooms deep enough to
+// rekey the path. Prints each mismatch and exits nonzero if there are any.
+
+#include "image.hpp"
+#include "rand.hpp"
+#include "window_image.hpp"
+#include "cantor/cantor.hpp"
+#include "cantor/cantor_zoom.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace chaos;
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+void CheckPhilox(Philox4x32::Counter ctr, Philox4x32::Key key, Philox4x32::Counter want) {
+  cases++;
+  Philox4x32::Counter got = Philox4x32::Generate(ctr, key);
+  if (got != want) {
+    std::printf("FAIL Philox4x32 ctr=%08x %08x %08x %08x key=%08x %08x: got %08x %08x %08x %08x, "
+                "want %08x %08x %08x %08x\n",
+                ctr[0], ctr[1], ctr[2], ctr[3], key[0], key[1], got[0], got[1], got[2], got[3],
+                want[0], want[1], want[2], want[3]);
+    failures++;
+  }
+}
+
+// Checks that the width x height image at (x0, y0) of expected matches actual.
+template <Image2dReadable ExpectedT, Image2dReadable ActualT>
+void CheckPixels(const std::string& name, const ExpectedT& expected, int x0, int y0, const ActualT& actual) {
+  cases++;
+  for (int y = 0; y < actual.height(); y++) {
+    for (int x = 0; x < actual.width(); x++) {
+      if (expected.read(x0 + x, y0 + y) != actual.read(x, y)) {
+        std::printf("FAIL %s: pixel (%d, %d) is %d, want %d\n", name.c_str(), x, y,
+                    int(actual.read(x, y)), int(expected.read(x0 + x, y0 + y)));
+        failures++;
+        return;
+      }
+    }
+  }
+}
+
+Cantor2dOptions RandomDust(unsigned int seed, double probability) {
+  return Cantor2dOptions{.seed = seed, .probability = probability, .counter_based_random = true};
+}
+
+void CheckTraversals(unsigned int seed) {
+  constexpr int kSize = 729;
+  Cantor2dOptions options = RandomDust(seed, 0.6);
+  std::string name = "seed " + std::to_string(seed);
+  Image2d<bool> serial(kSize, kSize);
+  DrawCantor2d(serial, options);
+
+  for (int threads : {2, 4}) {
+    Cantor2dOptions threaded = options;
+    threaded.threads = threads;
+    Image2d<bool> image(kSize, kSize);
+    DrawCantor2d(image, threaded);
+    CheckPixels(name + " threads=" + std::to_string(threads), serial, 0, 0, image);
+  }
+
+  // Windows that straddle sub-squares, so that culled squares must not
+  // change the choices of the ones that are kept.
+  constexpr int kWindow = 100;
+  for (int y0 = 0; y0 < kSize; y0 += 3*kWindow) {
+    for (int x0 = 0; x0 < kSize; x0 += 2*kWindow) {
+      Range2d window(x0, y0, std::min(kSize, x0 + kWindow), std::min(kSize, y0 + kWindow));
+      WindowImage2d<Image2d<bool>> image(kSize, kSize, window, Image2d<bool>(kWindow, kWindow));
+      DrawCantor2d(image, options);
+      Image2d<bool> stored(window.width(), window.height());
+      for (int y = 0; y < window.height(); y++) {
+        for (int x = 0; x < window.width(); x++) {
+          stored.write(x, y, image.storage().read(x, y));
+        }
+      }
+      CheckPixels(name + " window at (" + std::to_string(x0) + ", " + std::to_string(y0) + ")",
+                  serial, x0, y0, stored);
+    }
+  }
+
+  // Every square at depths 1 and 2, drawn on its own.
+  for (Cantor2dAddress<> parent; parent.depth < 2; parent = parent.Child(2, 1)) {
+    for (int j = 0; j < 3; j++) {
+      for (int i = 0; i < 3; i++) {
+        Cantor2dAddress<> address = parent.Child(i, j);
+        int size = (address.depth == 1) ? kSize/3 : kSize/9;
+        Image2d<bool> image(size, size);
+        DrawCantor2dAt(image, options, address);
+        CheckPixels(name + " DrawCantor2dAt depth " + std::to_string(address.depth) + " (" +
+                    std::to_string(int(address.x)) + ", " + std::to_string(int(address.y)) + ")",
+                    serial, int(address.x)*size, int(address.y)*size, image);
+      }
+    }
+  }
+}
+
+// Checks that the sub-squares of a square around depth kCantor2dPathDigits
+// match a zoom one level up, where paths are rekeyed.
+void CheckDeepZoom(unsigned int seed) {
+  constexpr int kSize = 243;
+  Cantor2dOptions options = RandomDust(seed, 0.97);
+  Cantor2dAddress<> parent;
+  for (int level = 0; level < internal::kCantor2dPathDigits; level++) {
+    parent = parent.Child(level % 3, (level / 3) % 3);
+  }
+  Image2d<bool> expected(kSize, kSize);
+  DrawCantor2dAt(expected, options, parent);
+  for (int j = 0; j < 3; j++) {
+    for (int i = 0; i < 3; i++) {
+      Image2d<bool> image(kSize/3, kSize/3);
+      DrawCantor2dAt(image, options, parent.Child(i, j));
+      CheckPixels("seed " + std::to_string(seed) + " DrawCantor2dAt depth " +
+                  std::to_string(parent.depth + 1) + " sub-square (" + std::to_string(i) + ", " +
+                  std::to_string(j) + ")",
+                  expected, i*kSize/3, j*kSize/3, image);
+    }
+  }
+}
+
+}  // namespace
+
+int main(void) {
+  // From kat_vectors in Random123 1.14.
+  CheckPhilox({0, 0, 0, 0}, {0, 0}, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  CheckPhilox({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+              {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+  CheckPhilox({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+              {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+
+  for (unsigned int seed : {1u, 7u, 12345u}) {
+    CheckTraversals(seed);
+    CheckDeepZoom(seed);
+  }
+
+  if (failures > 0) {
+    std::printf("%d of %d cases failed\n", failures, cases);
+    return 1;
+  }
+  std::printf("%d cases passed\n", cases);
+  return 0;
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_THREAD_POOL_HPP__
+#define __CHAOS_THREAD_POOL_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chaos {
+
+// A TaskGroup tracks tasks submitted to a ThreadPool so that they can be
+// waited on together.
+class TaskGroup {
+  public:
+    TaskGroup() = default;
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+  private:
+    friend class ThreadPool;
+    std::atomic<int> pending_{0};
+};
+
+// A ThreadPool runs tasks on a fixed set of threads. Each thread keeps its own
+// deque of tasks, runs the newest one first, and steals the oldest task from
+// another thread when it runs out. Tasks may submit and wait on further tasks;
+// a thread that waits keeps running queued tasks until its group is done.
+class ThreadPool {
+  public:
+    // Creates a pool that runs tasks on num_threads threads, counting the
+    // thread that calls Wait(). Values <= 0 use every hardware thread.
+    explicit ThreadPool(int num_threads) {
+      if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+      }
+      for (int i = 0; i < num_threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+      }
+      // Queue 0 belongs to threads outside the pool.
+      for (int i = 1; i < num_threads; i++) {
+        threads_.emplace_back([this, i] { WorkerLoop(i); });
+      }
+    }
+    ~ThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+      }
+      wake_.notify_all();
+      for (auto& thread : threads_) {
+        thread.join();
+      }
+    }
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Run(TaskGroup& group, std::function<void()> task) {
+      group.pending_.fetch_add(1, std::memory_order_relaxed);
+      Queue& queue = *queues_[CurrentIndex()];
+      {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(Task{std::move(task), &group});
+      }
+      {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        queued_++;
+      }
+      wake_.notify_one();
+    }
+
+    // Blocks until every task in group has finished.
+    void Wait(TaskGroup& group) {
+      int self = CurrentIndex();
+      while (group.pending_.load(std::memory_order_acquire) > 0) {
+        if (!TryRunOne(self)) {
+          std::this_thread::yield();
+        }
+      }
+    }
+
+    int num_threads() const {
+      return queues_.size();
+    }
+
+  private:
+    struct Task {
+      std::function<void()> fn;
+      TaskGroup* group;
+    };
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+
+    // Returns the index of the calling thread's queue.
+    int CurrentIndex() const {
+      return (current_pool_ == this) ? current_index_ : 0;
+    }
+
+    bool TryPop(int index, bool newest, Task& task) {
+      Queue& queue = *queues_[index];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) {
+        return false;
+      }
+      if (newest) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      queued_--;
+      return true;
+    }
+
+    bool TryRunOne(int self) {
+      Task task;
+      bool found = TryPop(self, true, task);
+      for (int i = 1; !found && i < int(queues_.size()); i++) {
+        found = TryPop((self + i) % queues_.size(), false, task);
+      }
+      if (!found) {
+        return false;
+      }
+      task.fn();
+      task.group->pending_.fetch_sub(1, std::memory_order_release);
+      return true;
+    }
+
+    void WorkerLoop(int index) {
+      current_pool_ = this;
+      current_index_ = index;
+      while (true) {
+        if (TryRunOne(index)) {
+          continue;
+        }
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+          return;
+        }
+      }
+    }
+
+    static inline thread_local const ThreadPool* current_pool_ = nullptr;
+    static inline thread_local int current_index_ = 0;
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> threads_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::atomic<int> queued_{0};
+    bool stop_ = false;
+};
+
+// Calls fn(y0, y1) for consecutive chunks of chunk_rows rows covering
+// [0, height), using pool. Even-numbered chunks run first and odd-numbered
+// chunks after them, so chunks that run at the same time are never adjacent.
+// Images that pack the end of one row and the start of the next into the same
+// word, like Image2d<bool>, can then be written without locks.
+template <typename Fn>
+void ParallelForRows(ThreadPool& pool, int height, int chunk_rows, Fn fn) {
+  chunk_rows = std::max(1, chunk_rows);
+  for (int parity = 0; parity < 2; parity++) {
+    TaskGroup group;
+    for (int y0 = parity*chunk_rows; y0 < height; y0 += 2*chunk_rows) {
+      int y1 = std::min(height, y0 + chunk_rows);
+      pool.Run(group, [&fn, y0, y1] { fn(y0, y1); });
+    }
+    pool.Wait(group);
+  }
+}
+
+} // namespace chaos
+
+#endif  // __CHAOS_THREAD_POOL_HPP__
@@ -0,0 +1,178 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_TILES_HPP__
+#define __CHAOS_TILES_HPP__
+
+#include "bit_image.hpp"
+#include "image.hpp"
+#include "pgm.hpp"
+#include "range.hpp"
+#include "status.hpp"
+#include "thread_pool.hpp"
+#include "window_image.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace chaos {
+
+struct TilePyramidOptions {
+  int tile_size = 256;
+  // kPgm writes 8-bit .pgm tiles; kPbm writes bilevel .pbm tiles.
+  PnmFormat format = PnmFormat::kPgm;
+  // Number of threads RenderAll uses; 0 uses every hardware thread.
+  int threads = 1;
+};
+
+// A TilePyramid renders a picture as a deep-zoom tile pyramid. The last level,
+// num_levels() - 1, is the full width x height resolution. Each level below
+// it is half the size of the one above, rounded up, down to level 0, which
+// fits in a single tile. Tile (x, y) of level z is stored in
+// directory/z/x/y.pgm (or .pbm).
+//
+// Tiles are rendered independently and only on request. draw(image) should
+// draw the complete picture onto image, as for RenderBandedPgm. image has
+// the level's full size but only keeps the pixels of one tile, and renderers
+// that honour clip_range() skip most of the work outside it. When
+// RenderAll runs on several threads, draw is called concurrently, each time
+// with a different image.
+template <typename DrawFn>
+class TilePyramid {
+  public:
+    TilePyramid(std::string directory, int width, int height, DrawFn draw, const TilePyramidOptions& options)
+        : directory_(std::move(directory)), width_(width), height_(height), draw_(std::move(draw)), options_(options) {
+      num_levels_ = 1;
+      while (level_width(0) > options_.tile_size || level_height(0) > options_.tile_size) {
+        num_levels_++;
+      }
+    }
+
+    int num_levels() const {
+      return num_levels_;
+    }
+    int level_width(int z) const {
+      return Downscale(width_, num_levels_ - 1 - z);
+    }
+    int level_height(int z) const {
+      return Downscale(height_, num_levels_ - 1 - z);
+    }
+    // The number of tiles across and down level z.
+    int columns(int z) const {
+      return (level_width(z) + options_.tile_size - 1)/options_.tile_size;
+    }
+    int rows(int z) const {
+      return (level_height(z) + options_.tile_size - 1)/options_.tile_size;
+    }
+    // The pixels of level z covered by tile (x, y). Tiles on the right and
+    // bottom edges may be smaller than tile_size.
+    Range2d TileRange(int z, int x, int y) const {
+      int size = options_.tile_size;
+      return Intersect(Range2d(x*size, y*size, (x+1)*size, (y+1)*size), Range2d(level_width(z), level_height(z)));
+    }
+    std::string TilePath(int z, int x, int y) const {
+      const char* extension = (options_.format == PnmFormat::kPbm) ? ".pbm" : ".pgm";
+      return directory_ + "/" + std::to_string(z) + "/" + std::to_string(x) + "/" + std::to_string(y) + extension;
+    }
+
+    // Renders tile (x, y) of level z, unless its file already exists.
+    Status RenderTile(int z, int x, int y) {
+      std::string path = TilePath(z, x, y);
+      std::error_code error;
+      if (std::filesystem::exists(path, error)) {
+        return Status{0, ""};
+      }
+      std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+      if (error) {
+        return Status{error.value(), "creating directory for " + path + ": " + error.message()};
+      }
+      Range2d window = TileRange(z, x, y);
+      if (options_.format == PnmFormat::kPbm) {
+        return RenderInto(BitImage2d(window.width(), window.height()), z, window, path);
+      }
+      return RenderInto(Image2d<uint8_t>(window.width(), window.height()), z, window, path);
+    }
+
+    // Renders every tile of every level that does not exist yet, returning
+    // the first error.
+    Status RenderAll() {
+      Status status{0, ""};
+      std::mutex status_mutex;
+      auto render = [&](int z, int x, int y) {
+        Status tile_status = RenderTile(z, x, y);
+        if (!tile_status.ok()) {
+          std::lock_guard<std::mutex> lock(status_mutex);
+          if (status.ok()) {
+            status = tile_status;
+          }
+        }
+      };
+      if (options_.threads == 1) {
+        ForEachTile(render);
+        return status;
+      }
+      ThreadPool pool(options_.threads);
+      TaskGroup group;
+      ForEachTile([&](int z, int x, int y) {
+        pool.Run(group, [&render, z, x, y] { render(z, x, y); });
+      });
+      pool.Wait(group);
+      return status;
+    }
+
+  private:
+    static int Downscale(int size, int halvings) {
+      for (int i = 0; i < halvings; i++) {
+        size = (size + 1)/2;
+      }
+      return size;
+    }
+
+    template <typename Fn>
+    void ForEachTile(Fn fn) const {
+      for (int z = 0; z < num_levels_; z++) {
+        for (int y = 0; y < rows(z); y++) {
+          for (int x = 0; x < columns(z); x++) {
+            fn(z, x, y);
+          }
+        }
+      }
+    }
+
+    // Draws the tile and writes it under a temporary name, renaming it into
+    // place once complete so that an interrupted run never leaves a partial
+    // tile that would be skipped next time.
+    template <typename StorageT>
+    Status RenderInto(StorageT storage, int z, Range2d window, const std::string& path) {
+      WindowImage2d<StorageT> image(level_width(z), level_height(z), window, std::move(storage));
+      draw_(image);
+      std::string temp_path = path + ".tmp";
+      PnmStreamWriter writer(temp_path, options_.format, window.width(), window.height());
+      writer.WriteRows(image.storage(), window.height());
+      Status status = writer.Close();
+      if (!status.ok()) {
+        return status;
+      }
+      std::error_code error;
+      std::filesystem::rename(temp_path, path, error);
+      if (error) {
+        return Status{error.value(), "renaming " + temp_path + ": " + error.message()};
+      }
+      return status;
+    }
+
+    std::string directory_;
+    int width_;
+    int height_;
+    DrawFn draw_;
+    TilePyramidOptions options_;
+    int num_levels_;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_TILES_HPP__
@@ -3,7 +3,9 @@
 #ifndef __CHAOS_UTILS_HPP__
 #define __CHAOS_UTILS_HPP__
 
+#include "fill.hpp"
 #include "image.hpp"
+#include "stats.hpp"
 
 #include <algorithm>
 
@@ -33,6 +35,27 @@ void SafeWrite(ImageT& image, int x, int y, typename ImageT::pixel_type p) {
   image.write(x, y, p);
 }
 
+// As SafeWrite, reporting writes that fall outside the image to stats.
+template <Image2dWritable ImageT, RenderStatsCollector StatsT>
+void SafeWrite(ImageT& image, int x, int y, typename ImageT::pixel_type p, StatsT& stats) {
+  if (x < 0 || x >= image.width() || y < 0 || y >= image.height()) {
+    stats.RejectWrite();
+    return;
+  }
+  image.write(x, y, p);
+}
+
+// As Fill, reporting each pixel of [x0, x1) that falls outside the image to
+// stats. Meant for spans of a few pixels, like the leaves of a 1-D fractal.
+template <Image1dWritable ImageT, RenderStatsCollector StatsT>
+void SafeFill(ImageT& image, int x0, int x1, typename ImageT::pixel_type p, StatsT& stats) {
+  int inside = std::max(0, std::min(int(image.width()), x1) - std::max(0, x0));
+  for (int rejected = std::max(0, x1 - x0) - inside; rejected > 0; rejected--) {
+    stats.RejectWrite();
+  }
+  Fill(image, x0, x1, p);
+}
+
 template <Image1dReadable SourceImageT, Image1dWritable DestImageT>
 void SafeCopy(const SourceImageT& source, DestImageT& dest) {
   int width = std::min(source.width(), dest.width());
@@ -0,0 +1,204 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_WARP_HPP__
+#define __CHAOS_WARP_HPP__
+
+#include "image.hpp"
+#include "range.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace chaos {
+
+enum class WarpMapping {
+  // Position along the line is angle: the line wraps once around the ring,
+  // clockwise from the positive x axis, and its two ends meet at theta = 2pi.
+  kPolar,
+  // Position along the line is log(radius): the line runs outward from
+  // inner_r to outer_r, each position drawn as a full circle, so equal
+  // ratios of radius get equal lengths of line.
+  kLogPolar,
+};
+
+struct PolarWarpOptions {
+  // The ring around the center of the image that the line is drawn on, in
+  // pixels. kLogPolar needs inner_r > 0.
+  double inner_r = 0;
+  double outer_r = 0;
+  WarpMapping mapping = WarpMapping::kPolar;
+  // Number of threads to warp with; 0 uses every hardware thread. With more
+  // than one thread, dest must accept concurrent writes to rows that are at
+  // least a few rows apart.
+  int threads = 1;
+};
+
+namespace internal {
+
+// The math below vectorizes: it has no branches or library calls, and no
+// selects between computed values, which the compiler will not speculate
+// under the default -ftrapping-math. Signs are applied with copysign instead.
+
+// atan2(y, x) in (-pi, pi], accurate to about 1e-11. atan is reduced to
+// t in [0, 1] by symmetry, then to s in [-tan(pi/8), tan(pi/8)] with
+// atan(t) = pi/8 + atan(s), s = (t - tan(pi/8))/(1 + t*tan(pi/8)), where its
+// series converges quickly.
+inline double Atan2(double y, double x) {
+  constexpr double kPi = 3.14159265358979323846;
+  double ax = std::abs(x);
+  double ay = std::abs(y);
+  double t = std::min(ax, ay)/std::max(std::max(ax, ay), 1e-300);
+  constexpr double kTanPi8 = 0.41421356237309504880;
+  double s = (t - kTanPi8)/(1 + t*kTanPi8);
+  double s2 = s*s;
+  double series = -1.0/23;
+  for (int k = 21; k >= 1; k -= 2) {
+    series = ((k/2) % 2 ? -1.0 : 1.0)/k + s2*series;
+  }
+  double a = kPi/8 + s*series;
+  // Reflect about pi/4 when |y| > |x|, then about pi/2 when x < 0.
+  a = kPi/4 + std::copysign(1.0, ax - ay)*(a - kPi/4);
+  a = kPi/2 + std::copysign(1.0, x)*(a - kPi/2);
+  return std::copysign(a, y);
+}
+
+// log(x) for normal, positive x, accurate to a few ulp. x is split into
+// 2^k*m with m in [sqrt(1/2), sqrt(2)) by integer operations on its bits,
+// and log(m) = 2*atanh((m - 1)/(m + 1)) is summed as a series.
+inline double Log(double x) {
+  constexpr uint64_t kSqrtHalfBits = 0x3fe6a09e667f3bcd;
+  constexpr uint64_t kMantissaMask = (uint64_t(1) << 52) - 1;
+  // Biases k by 1024 so that the exponent field below is never negative.
+  constexpr uint64_t kExponentBias = uint64_t(1024) << 52;
+  constexpr double kTwo52 = 4503599627370496.0;
+  constexpr double kLn2 = 0.693147180559945309417;
+  uint64_t shifted = std::bit_cast<uint64_t>(x) - kSqrtHalfBits + kExponentBias;
+  double m = std::bit_cast<double>((shifted & kMantissaMask) + kSqrtHalfBits);
+  // Converts k + 1024 to double by placing it in the mantissa of 2^52.
+  double k = std::bit_cast<double>((shifted >> 52) | std::bit_cast<uint64_t>(kTwo52)) - (kTwo52 + 1024);
+  double s = (m - 1)/(m + 1);
+  double s2 = s*s;
+  double series = 1.0/19;
+  for (int n = 17; n >= 1; n -= 2) {
+    series = 1.0/n + s2*series;
+  }
+  return k*kLn2 + 2*s*series;
+}
+
+// Computes the position along the line of pixels [x0, x1) of a row, dy
+// below the center. Positions are in [0, line_width]; pixels outside the
+// ring get meaningless positions, and are filtered out by the caller.
+inline void WarpRow(int x0, int x1, double dy, double center_x, int line_width, const PolarWarpOptions& options, double* u) {
+  constexpr double kPi = 3.14159265358979323846;
+  if (options.mapping == WarpMapping::kPolar) {
+    double scale = line_width/(2*kPi);
+    for (int x = x0; x < x1; x++) {
+      double dx = x + 0.5 - center_x;
+      // The angle in (0, 2pi], found by rotating the point by pi.
+      u[x - x0] = (kPi + Atan2(-dy, -dx))*scale;
+    }
+  } else {
+    double log_inner = std::log(options.inner_r);
+    double scale = line_width/(std::log(options.outer_r) - log_inner);
+    double dy2 = dy*dy;
+    for (int x = x0; x < x1; x++) {
+      double dx = x + 0.5 - center_x;
+      // r2 can be 0 at the center, which is outside the ring.
+      u[x - x0] = (0.5*Log(dx*dx + dy2) - log_inner)*scale;
+    }
+  }
+}
+
+}  // namespace internal
+
+// Draws line, a 1-D image such as one rendered by DrawMultiGapCantor1d, onto
+// the ring around the center of dest described by options. This replaces
+// LineWriterPolarArc: rather than subdividing arcs until they are smaller
+// than a pixel, it maps each pixel of the ring back to a position on the line
+// once, and samples the line there. Pixels whose sample is zero are left
+// alone, so several rings can be drawn onto one image.
+//
+// A line as wide as the outer circumference, 2*pi*outer_r, keeps every
+// line pixel at most one image pixel long.
+template <Image1dReadable LineT, Image2dWritable DestT>
+void WarpPolar(const LineT& line, DestT& dest, const PolarWarpOptions& options) {
+  int line_width = line.width();
+  if (line_width <= 0 || options.outer_r <= options.inner_r ||
+      (options.mapping == WarpMapping::kLogPolar && options.inner_r <= 0)) {
+    return;
+  }
+  double center_x = dest.width()/2.0;
+  double center_y = dest.height()/2.0;
+  double inner2 = options.inner_r*options.inner_r;
+  double outer2 = options.outer_r*options.outer_r;
+  Range2d clip = ClipRange(dest);
+  int y_begin = std::max(clip.y0, int(std::floor(center_y - options.outer_r)));
+  int y_end = std::min(clip.y1, int(std::ceil(center_y + options.outer_r)));
+  if (y_begin >= y_end) {
+    return;
+  }
+
+  auto warp_rows = [&](int row0, int row1) {
+    std::vector<double> u(std::max(0, clip.width()));
+    auto warp_span = [&](int y, double dy, int x0, int x1) {
+      if (x0 >= x1) {
+        return;
+      }
+      internal::WarpRow(x0, x1, dy, center_x, line_width, options, u.data());
+      double dy2 = dy*dy;
+      for (int x = x0; x < x1; x++) {
+        double dx = x + 0.5 - center_x;
+        double r2 = dx*dx + dy2;
+        if (r2 < inner2 || r2 >= outer2) {
+          continue;
+        }
+        int index = int(u[x - x0]);
+        if (index >= line_width) {
+          // The far end, which for kPolar is where the line wraps back to
+          // its start.
+          index = (options.mapping == WarpMapping::kPolar) ? index - line_width : line_width - 1;
+        }
+        auto value = line.read(index);
+        if (value) {
+          dest.write(x, y, value);
+        }
+      }
+    };
+    for (int y = y_begin + row0; y < y_begin + row1; y++) {
+      double dy = y + 0.5 - center_y;
+      double dy2 = dy*dy;
+      if (dy2 >= outer2) {
+        continue;
+      }
+      // Pixels outside [x0, x1) are outside the outer circle, and pixels in
+      // [hole_x0, hole_x1) inside the inner one; the per-pixel test in
+      // warp_span settles the pixels in between.
+      double half = std::sqrt(outer2 - dy2);
+      int x0 = std::max(clip.x0, int(std::floor(center_x - half - 0.5)));
+      int x1 = std::min(clip.x1, int(std::ceil(center_x + half + 0.5)));
+      int hole_x0 = x1;
+      int hole_x1 = x1;
+      if (dy2 < inner2) {
+        double hole = std::sqrt(inner2 - dy2);
+        hole_x0 = std::clamp(int(std::ceil(center_x - hole - 0.5)) + 1, x0, x1);
+        hole_x1 = std::clamp(int(std::floor(center_x + hole - 0.5)) - 1, hole_x0, x1);
+      }
+      warp_span(y, dy, x0, hole_x0);
+      warp_span(y, dy, hole_x1, x1);
+    }
+  };
+  if (options.threads == 1) {
+    warp_rows(0, y_end - y_begin);
+    return;
+  }
+  ThreadPool pool(options.threads);
+  ParallelForRows(pool, y_end - y_begin, 16, warp_rows);
+}
+
+} // namespace chaos
+
+#endif // __CHAOS_WARP_HPP__
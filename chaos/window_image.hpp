@@ -0,0 +1,91 @@
+// Copyright (c) 2025 Greg Prisament
+// See LICENSE file.
+#ifndef __CHAOS_WINDOW_IMAGE_HPP__
+#define __CHAOS_WINDOW_IMAGE_HPP__
+
+#include "fill.hpp"
+#include "image.hpp"
+#include "range.hpp"
+
+#include <utility>
+
+namespace chaos {
+
+// A WindowImage2d presents a large virtual image but only stores the pixels
+// inside a movable window. Writes outside the window are discarded and reads
+// outside it return pixel_type(). Renderers that honour clip_range() skip the
+// work for everything outside the window.
+template <Image2dReadWritable StorageT>
+class WindowImage2d {
+  public:
+    using storage_type = StorageT;
+    using pixel_type = typename StorageT::pixel_type;
+
+    // storage must be at least as large as any window that will be set.
+    WindowImage2d(int width, int height, Range2d window, storage_type storage)
+        : width_(width), height_(height), window_(window), storage_(std::move(storage)) {}
+
+    void write(int x, int y, pixel_type value) {
+      if (Contains(x, y)) {
+        storage_.write(x - window_.x0, y - window_.y0, value);
+      }
+    }
+    void write_span(int x0, int x1, int y, pixel_type value) {
+      if (y < window_.y0 || y >= window_.y1) {
+        return;
+      }
+      x0 = std::max(x0, window_.x0);
+      x1 = std::min(x1, window_.x1);
+      if (x0 < x1) {
+        internal::WriteSpan(storage_, x0 - window_.x0, x1 - window_.x0, y - window_.y0, value);
+      }
+    }
+    void fill_rect(Range2d range, pixel_type value) {
+      Range2d visible = Intersect(range, window_);
+      if (!visible.empty()) {
+        internal::FillRect(storage_, Range2d(
+            visible.x0 - window_.x0, visible.y0 - window_.y0,
+            visible.x1 - window_.x0, visible.y1 - window_.y0), value);
+      }
+    }
+    pixel_type read(int x, int y) const {
+      if (!Contains(x, y)) {
+        return pixel_type();
+      }
+      return storage_.read(x - window_.x0, y - window_.y0);
+    }
+    Range2d clip_range() const {
+      return window_;
+    }
+    int width() const {
+      return width_;
+    }
+    int height() const {
+      return height_;
+    }
+
+    // Moves the window and clears the stored pixels.
+    void set_window(Range2d window) {
+      window_ = window;
+      Fill(storage_, Range2d(window_.width(), window_.height()), pixel_type());
+    }
+    Range2d window() const {
+      return window_;
+    }
+    // The stored pixels; pixel (0, 0) is the top left corner of the window.
+    const storage_type& storage() const {
+      return storage_;
+    }
+  private:
+    bool Contains(int x, int y) const {
+      return x >= window_.x0 && x < window_.x1 && y >= window_.y0 && y < window_.y1;
+    }
+    int width_;
+    int height_;
+    Range2d window_;
+    storage_type storage_;
+};
+
+} // namespace chaos
+
+#endif // __CHAOS_WINDOW_IMAGE_HPP__